@@ -0,0 +1,191 @@
+#-------------------------------------------------------------------------------
+# Copyright (C) 2025 Analog Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+#
+# Time every provisioning phase over N runs, on hardware or on the host simulator
+# (src/max32657_bl1_provision/host). Host side phases come from the J-Link session,
+# target side phases from the cycle counts of the result block. Writes every run and
+# min/p50/p90/p99/max per phase as JSON and/or CSV.
+#
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+import enable_secureboot as es
+
+SIMULATOR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "..",
+	"src", "max32657_bl1_provision", "host", "build", "bl1_provision_host")
+
+# Host phase of each J-Link session step, see JLinkSession.timings
+HOST_PHASES = {"open": "connect", "connect": "connect", "loadfile": "download", "loadbin": "params",
+	"h": "start", "halt": "start", "r": "start", "reset": "start", "w4": "start", "mem32write": "start",
+	"setpc": "start", "g": "start", "go": "start", "sleep": "start", "jlinkexe": "jlinkexe",
+	"wait": "run"}
+
+PERCENTILES = (50, 90, 99)
+
+
+def percentile(values, p):
+	"""p-th percentile, interpolating between the nearest ranks"""
+	values = sorted(values)
+	rank = (len(values) - 1) * p / 100.0
+	low = int(rank)
+	high = min(low + 1, len(values) - 1)
+	return values[low] + (values[high] - values[low]) * (rank - low)
+
+
+def run_hardware(serial, params, session, timeout):
+	"""One provisioning run over J-Link, returns (error, result, host phase ms)"""
+	timings = []
+	with tempfile.TemporaryDirectory() as workdir:
+		error, result = es.provision_device(serial, workdir, params, timeout, session,
+			subprocess.DEVNULL, timings)
+	host = {}
+	for step, seconds in timings:
+		phase = HOST_PHASES.get(step)
+		if phase:
+			host[phase] = host.get(phase, 0.0) + seconds * 1000.0
+	return error, result, host
+
+
+def run_simulator(simulator, params, timeout):
+	"""One run of the host build on a fresh simulated part, returns (error, result, host phase ms)"""
+	with tempfile.TemporaryDirectory() as workdir:
+		paths = {name: os.path.join(workdir, name + ".bin") for name in ("infoblock", "params", "result")}
+		with open(paths["params"], "wb") as f:
+			f.write(params)
+		env = dict(os.environ, HAL_HOST_INFOBLOCK=paths["infoblock"],
+			HAL_HOST_MAILBOX=paths["params"], HAL_HOST_RESULT=paths["result"])
+		start = time.monotonic()
+		try:
+			proc = subprocess.run([simulator], env=env, stdin=subprocess.DEVNULL,
+				stdout=subprocess.PIPE, timeout=timeout)
+		except subprocess.TimeoutExpired:
+			return "no result within %.0f s" % timeout, None, {}
+		host = {"run": (time.monotonic() - start) * 1000.0, "uart_bytes": len(proc.stdout)}
+		if not os.path.exists(paths["result"]):
+			return "simulator exit code %d" % proc.returncode, None, host
+		with open(paths["result"], "rb") as f:
+			return None, es.parse_result(f.read()), host
+
+
+def summarize(runs):
+	"""min/percentiles/max/mean of every metric over the runs that have it"""
+	metrics = sorted({key for run in runs for key in run["metrics"]})
+	summary = {}
+	for key in metrics:
+		values = [run["metrics"][key] for run in runs if key in run["metrics"]]
+		entry = {"n": len(values), "min": min(values), "max": max(values),
+			"mean": sum(values) / len(values)}
+		for p in PERCENTILES:
+			entry["p%d" % p] = percentile(values, p)
+		summary[key] = entry
+	return metrics, summary
+
+
+def write_csv(path, runs, metrics):
+	with open(path, "w", newline="") as f:
+		writer = csv.writer(f)
+		writer.writerow(["iteration", "passed", "error"] + metrics)
+		for run in runs:
+			writer.writerow([run["iteration"], int(run["passed"]), run["error"] or ""] +
+				[("%.3f" if key.endswith("_ms") else "%d") % run["metrics"][key]
+				if key in run["metrics"] else "" for key in metrics])
+
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser(description="Per phase provisioning timing over N runs")
+	parser.add_argument("-c", "--cert", required=True, help="certificate FILE", metavar="FILE")
+	parser.add_argument("-n", "--iterations", type=int, default=10, help="number of runs")
+	parser.add_argument("--simulator", nargs="?", const=SIMULATOR,
+		help="run the host build instead of hardware, a fresh simulated part each run")
+	parser.add_argument("--probe", help="J-Link serial number, needed when several probes are attached")
+	parser.add_argument("--jlinkexe", action="store_true",
+		help="run J-Link Commander instead of one in-process J-Link session")
+	parser.add_argument("--lock", choices=es.LOCK_POLICIES.keys(), default="none",
+		help="lock policy, none by default so one part can be run again")
+	parser.add_argument("--pause", action="store_true", help="wait for Enter before each hardware run")
+	parser.add_argument("--timeout", type=float, default=10.0, help="seconds to wait for each result")
+	parser.add_argument("--json", help="write every run and the summary to this file")
+	parser.add_argument("--csv", help="write one row per run to this file")
+	parser.add_argument("-y", "--yes", action="store_true", help="do not ask for confirmation")
+	args = parser.parse_args()
+
+	# Older firmware ignores the mailbox, it would provision with the .pubkey key and lock for good
+	if not args.simulator and not es.elf_has_mailbox(es.PROVISION_ELF):
+		print("%s has no parameter mailbox, rebuild it from src/max32657_bl1_provision." %
+			es.PROVISION_ELF)
+		sys.exit(1)
+	# The target phases and the outcome of each run come from the result block
+	if not args.simulator and not es.elf_has_result_block(es.PROVISION_ELF):
+		print("%s has no result block, rebuild it from src/max32657_bl1_provision." %
+			es.PROVISION_ELF)
+		sys.exit(1)
+
+	pub_key = es.public_key(args.cert)
+	params = es.build_params(pub_key, es.LOCK_POLICIES[args.lock], 0)
+	session = not args.jlinkexe and es.jlink_session.available()
+
+	if not args.simulator and not args.yes:
+		print("Every hardware run writes the key in the OTP of the attached part, lock policy %s." %
+			args.lock)
+		if input("Do you want to continue? (Y/N): ").strip().upper() not in ["Y", "YES"]:
+			sys.exit(0)
+
+	runs = []
+	for i in range(args.iterations):
+		if args.pause and not args.simulator:
+			input("Run %d: attach the next part and press Enter" % (i + 1))
+		start = time.monotonic()
+		if args.simulator:
+			error, result, host = run_simulator(args.simulator, params, args.timeout)
+		else:
+			error, result, host = run_hardware(args.probe, params, session, args.timeout)
+		total = (time.monotonic() - start) * 1000.0
+
+		metrics = {"total_ms": total}
+		for phase, value in host.items():
+			metrics[phase if phase == "uart_bytes" else "host_%s_ms" % phase] = value
+		if result is not None:
+			for name, status, ms in result["steps"]:
+				metrics["target_%s_ms" % name] = ms
+		elif error is None:
+			error = "no result within %.0f s" % args.timeout
+		passed = error is None and es.result_passed(result, pub_key)
+		runs.append({"iteration": i + 1, "passed": passed, "error": error, "metrics": metrics})
+		print("run %d: %s, %.1f ms%s" % (i + 1, "PASS" if passed else "FAIL", total,
+			", " + error if error else ""))
+
+	metrics, summary = summarize(runs)
+	print("\n%-26s %5s %10s %10s %10s %10s %10s" % ("metric", "n", "min", "p50", "p90", "p99", "max"))
+	for key in metrics:
+		e = summary[key]
+		print("%-26s %5d %10.3f %10.3f %10.3f %10.3f %10.3f" % (key, e["n"], e["min"], e["p50"],
+			e["p90"], e["p99"], e["max"]))
+
+	if args.json:
+		with open(args.json, "w") as f:
+			json.dump({"target": "simulator" if args.simulator else "hardware",
+				"transport": None if args.simulator else ("session" if session else "jlinkexe"),
+				"lock": args.lock, "runs": runs, "summary": summary}, f, indent=2)
+	if args.csv:
+		write_csv(args.csv, runs, metrics)
+
+	sys.exit(0 if all(run["passed"] for run in runs) else 1)
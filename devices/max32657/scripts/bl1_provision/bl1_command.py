@@ -0,0 +1,86 @@
+#-------------------------------------------------------------------------------
+# Copyright (C) 2025 Analog Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+#
+# Drive the provisioning firmware in command mode (built with BL1_COMMAND_MODE, or
+# entered from the "Command Mode" test menu entry). Each command ends with
+#   RES <name> status=<error code> us=<elapsed microseconds>
+# and several commands can share one line separated by ';'.
+#
+import argparse
+import re
+import sys
+import time
+
+import serial
+
+RESULT = re.compile(rb"RES (\S+) status=(-?\d+) us=(\d+)\r\n")
+
+
+class CommandResult:
+	def __init__(self, name, status, us, output):
+		self.name = name
+		self.status = status
+		self.us = us
+		self.output = output
+
+	def __repr__(self):
+		return "%s status=%d us=%d" % (self.name, self.status, self.us)
+
+
+class Bl1Session:
+	def __init__(self, ser, timeout=10.0):
+		self.ser = ser
+		self.timeout = timeout
+		self.pending = b""
+
+	def run(self, line):
+		"""Send one line of ';' separated commands, return one CommandResult per command"""
+		count = len([c for c in line.split(";") if c.strip()])
+		self.ser.write(line.encode("ascii") + b"\r")
+
+		results = []
+		deadline = time.monotonic() + self.timeout
+		while len(results) < count:
+			match = RESULT.search(self.pending)
+			if match is None:
+				if time.monotonic() > deadline:
+					raise TimeoutError("no reply to '%s'" % line)
+				self.pending += self.ser.read(self.ser.in_waiting or 1)
+				continue
+			output, self.pending = self.pending[:match.start()], self.pending[match.end():]
+			results.append(CommandResult(match.group(1).decode(), int(match.group(2)),
+				int(match.group(3)), output))
+		return results
+
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser(description="Run provisioning firmware commands")
+	parser.add_argument("--port", required=True, help="serial port, e.g. /dev/ttyUSB0 or COM3")
+	parser.add_argument("--baud", type=int, default=115200, help="serial baud rate")
+	parser.add_argument("--timeout", type=float, default=10.0, help="seconds to wait for each line")
+	parser.add_argument("lines", nargs="+", help="command lines, e.g. \"usn; swd.status\"")
+	args = parser.parse_args()
+
+	failed = False
+	with serial.Serial(args.port, args.baud, timeout=0.1) as ser:
+		session = Bl1Session(ser, args.timeout)
+		for line in args.lines:
+			for result in session.run(line):
+				sys.stdout.write(result.output.decode("ascii", "replace"))
+				print(result)
+				failed = failed or result.status != 0
+
+	sys.exit(1 if failed else 0)
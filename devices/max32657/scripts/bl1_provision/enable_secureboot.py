@@ -15,10 +15,48 @@
 #-------------------------------------------------------------------------------
 import sys
 import os
+import re
+import time
 import argparse
 import base64
+import hashlib
+import struct
+import subprocess
+import tempfile
+import zlib
+from concurrent.futures import ThreadPoolExecutor
 from elftools.elf.elffile import ELFFile
 
+import jlink_session
+
+JLinkExe = "JLink" if os.name == "nt" else "JLinkExe"
+PROVISION_ELF = "bl1_provision.elf"
+JLINK_ARGS = ["-device", "MAX32657", "-if", "swd", "-speed", "2000", "-autoconnect", "1"]
+
+# Parameter mailbox, see src/max32657_bl1_provision/include/mailbox.h
+PARAMS_ADDRESS = 0x3003F000
+PARAMS_MAGIC = 0x50314C42
+PARAMS_VERSION = 1
+TAG_CRK = 0x0001
+TAG_LOCK_POLICY = 0x0002
+TAG_FLAGS = 0x0003
+LOCK_POLICIES = {"none": 0, "debug": 1, "permanent": 2}
+FLAG_COMMAND_MODE = 1 << 0
+FLAG_TEST_MENU = 1 << 1
+
+# Result block in the second half of the mailbox
+RESULT_ADDRESS = 0x3003F800
+RESULT_MAGIC = 0x52314C42
+RESULT_VERSION = 1
+RESULT_FORMAT = "<IIIi8i8II4I16s32s"
+RESULT_SIZE = struct.calcsize(RESULT_FORMAT)
+PHASES = {0: "boot", 1: "usn", 2: "params", 3: "crk", 4: "swd_lock", 5: "swd_permanent",
+	6: "console", 0xFF: "done"}
+PHASE_DONE = 0xFF
+STATUS_NOT_RUN = 1
+USN_LENGTH = 13
+ERRORS = {-3: "E_BAD_PARAM", -4: "E_INVALID", -7: "E_BAD_STATE", -8: "E_UNKNOWN", -14: "E_NONE_AVAIL"}
+
 
 def convert_pem_to_der(cert_pem):
 	with open(cert_pem, 'r') as f:
@@ -32,6 +70,44 @@ def convert_pem_to_der(cert_pem):
 	return key_bytes
 
 
+def public_key(cert):
+	"""Raw 64 byte public key (X || Y) of a prime256v1 private key PEM file"""
+	key_bytes = convert_pem_to_der(cert)
+	pub_offset = 57
+	return key_bytes[pub_offset:(pub_offset+64)]
+
+
+def build_params(pub_key, lock_policy, flags):
+	"""Parameter manifest for the SRAM mailbox: header, then tag/length/value items"""
+	tlv = b""
+	for tag, value in ((TAG_CRK, pub_key), (TAG_LOCK_POLICY, bytes([lock_policy])),
+			(TAG_FLAGS, struct.pack("<I", flags))):
+		tlv += struct.pack("<HH", tag, len(value)) + value
+	return struct.pack("<IHHI", PARAMS_MAGIC, PARAMS_VERSION, len(tlv), zlib.crc32(tlv)) + tlv
+
+
+def elf_has_symbol(elf_file, name):
+	with open(elf_file, 'rb') as f:
+		symtab = ELFFile(f).get_section_by_name(".symtab")
+		return symtab is not None and bool(symtab.get_symbol_by_name(name))
+
+
+def elf_has_mailbox(elf_file):
+	"""
+	True if the firmware reads its parameters from the SRAM mailbox. Older builds only read
+	the .pubkey section, and the mailbox address is the top of their stack.
+	"""
+	with open(elf_file, 'rb') as f:
+		if ELFFile(f).get_section_by_name(".mailbox") is not None:
+			return True
+	return elf_has_symbol(elf_file, "_mailbox_params_start")
+
+
+def elf_has_result_block(elf_file):
+	"""True if the firmware fills the result block, older builds never mark one done"""
+	return elf_has_symbol(elf_file, "_mailbox_result_start")
+
+
 def update_section_in_elf(cert, elf_file, section_name):
 	with open(elf_file, 'r+b') as f:
 		elf = ELFFile(f)
@@ -47,25 +123,267 @@ def update_section_in_elf(cert, elf_file, section_name):
 			print('Section size is not correct')
 			return
 
-		key_bytes = convert_pem_to_der(cert)
-		pub_offset = 57
-		pub_key = key_bytes[pub_offset:(pub_offset+64)]
+		pub_key = public_key(cert)
 
 		# Update section
 		f.seek(section.header['sh_offset'])
 		f.write(pub_key)
 
 
-def bl1_provision():
-	# Execute JLink Script
-	JLinkExe = "JLink" if os.name == "nt" else "JLinkExe"
-	os.system(JLinkExe + " -device MAX32657 -if swd -speed 2000 -autoconnect 1 -CommanderScript JLinkScript")
+def run_jlinkexe(serial, workdir, script, log=None):
+	"""Run a script with J-Link Commander, output to log or the console, returns its exit code"""
+	usb = ["-USB", serial] if serial else []
+	# Without -ExitOnError J-Link Commander exits with 0 whatever happened
+	return subprocess.run([JLinkExe] + usb + JLINK_ARGS +
+		["-NoGui", "1", "-ExitOnError", "1", "-CommanderScript", script],
+		cwd=workdir, stdout=log, stderr=subprocess.STDOUT, stdin=subprocess.DEVNULL).returncode
+
+
+def list_probes():
+	"""Serial numbers of all J-Link probes attached over USB"""
+	with tempfile.TemporaryDirectory() as tmp:
+		script = os.path.join(tmp, "ShowEmuList.jlink")
+		with open(script, "w") as f:
+			f.write("ShowEmuList\nq\n")
+		out = subprocess.run([JLinkExe, "-NoGui", "1", "-CommanderScript", script],
+			stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True).stdout
+	return sorted(set(re.findall(r"Serial number:\s*(\d+)", out)))
+
+
+def elf_entry(elf_file):
+	"""Entry point of an ELF file, without the Thumb bit"""
+	with open(elf_file, 'rb') as f:
+		return ELFFile(f).header['e_entry'] & ~1
+
+
+def parse_image(image):
+	"""(path, address) of an --image argument, FILE or FILE@ADDRESS, the address only for .bin"""
+	path, _, address = image.partition("@")
+	return os.path.abspath(path), int(address, 0) if address else None
+
+
+def make_jlink_script(workdir, params=None, images=()):
+	"""
+	Copy JLinkScript into workdir, with absolute paths so every probe can run from its own folder.
+	The images, (path, address or None) pairs, are programmed before the first loadfile so the
+	final firmware and the provisioning ELF share one connection. SetPC takes the entry point
+	of the ELF loaded last.
+	With params, also write them to workdir and load them into the mailbox before starting.
+	The result block magic is cleared so a result left in SRAM by an earlier run is ignored.
+	"""
+	lines = []
+	started = False
+	entry = None
+	with open("JLinkScript") as f:
+		for line in f:
+			match = re.match(r"(\s*loadfile\s+)(\S+)(.*)", line, re.IGNORECASE)
+			if match:
+				for path, address in images:
+					address = "" if address is None else " 0x%08X" % address
+					lines.append("loadfile %s%s\n" % (path, address))
+				images = ()
+				path = os.path.abspath(match.group(2))
+				line = match.group(1) + path + match.group(3) + "\n"
+				if path.lower().endswith(".elf"):
+					entry = elf_entry(path)
+			match = re.match(r"(\s*SetPC\s+)(\S+)(.*)", line, re.IGNORECASE)
+			if match and entry is not None:
+				line = "%s0x%08X%s\n" % (match.group(1), entry, match.group(3))
+			if not started and re.match(r"\s*(SetPC|g)\b", line, re.IGNORECASE):
+				if params is not None:
+					path = os.path.join(workdir, "params.bin")
+					with open(path, "wb") as p:
+						p.write(params)
+					lines.append("loadbin %s 0x%08X\n" % (path, PARAMS_ADDRESS))
+				lines.append("w4 0x%08X 0\n" % RESULT_ADDRESS)
+				started = True
+			lines.append(line)
+
+	script = os.path.join(workdir, "JLinkScript")
+	with open(script, "w") as f:
+		f.writelines(lines)
+	return script
+
+
+def read_result(serial, workdir):
+	"""Raw result block read over SWD without halting the firmware, None if the probe failed"""
+	script = os.path.join(workdir, "ReadResult.jlink")
+	path = os.path.join(workdir, "result.bin")
+	with open(script, "w") as f:
+		f.write("savebin %s 0x%08X 0x%X\nq\n" % (path, RESULT_ADDRESS, RESULT_SIZE))
+	if os.path.exists(path):
+		os.remove(path)
+	ret = run_jlinkexe(serial, workdir, script, subprocess.DEVNULL)
+	if ret != 0 or not os.path.exists(path):
+		return None
+	with open(path, "rb") as f:
+		return f.read()
+
+
+def parse_result(data):
+	"""Decode a result block, None unless it holds a result of this firmware version"""
+	if data is None or len(data) < RESULT_SIZE:
+		return None
+	fields = struct.unpack(RESULT_FORMAT, data[:RESULT_SIZE])
+	if fields[0] != RESULT_MAGIC or fields[1] != RESULT_VERSION:
+		return None
+	hz = fields[20] or 1
+	return {
+		"phase": fields[2],
+		"status": fields[3],
+		# step_status[phase - 1], step_cycles[phase - 1]
+		"steps": [(PHASES.get(p, "step%d" % p), fields[3 + p], fields[11 + p] * 1000.0 / hz)
+			for p in range(1, 9) if fields[3 + p] != STATUS_NOT_RUN],
+		"debug": {"locks": fields[21], "unlocks": fields[22], "locked": fields[23],
+			"permanent": fields[24]},
+		"usn": fields[25][:USN_LENGTH].hex().upper(),
+		"crk_sha256": fields[26].hex(),
+	}
+
+
+def wait_result(read, timeout, interval):
+	"""Poll the result block with read() until the firmware marks it done, None on timeout"""
+	deadline = time.monotonic() + timeout
+	while True:
+		result = parse_result(read())
+		if result is not None and result["phase"] == PHASE_DONE:
+			return result
+		if time.monotonic() > deadline:
+			return None
+		time.sleep(interval)
+
+
+def result_passed(result, pub_key):
+	"""The firmware reported success and the CRK in the part is the key we meant to write"""
+	return result is not None and result["status"] == 0 and \
+		result["crk_sha256"] == hashlib.sha256(pub_key).hexdigest()
+
+
+def print_result(result, pub_key):
+	print("USN:            " + result["usn"])
+	for name, status, ms in result["steps"]:
+		print("%-15s %s, %.3f ms" % (name + ":", "ok" if status == 0 else
+			"status %d %s" % (status, ERRORS.get(status, "")), ms))
+	match = result["crk_sha256"] == hashlib.sha256(pub_key).hexdigest()
+	print("CRK SHA-256:    %s (%s)" % (result["crk_sha256"],
+		"matches the certificate" if match else "DIFFERS from the certificate"))
+	print("Debug port:     %s, %s, %d locks and %d unlocks left" % (
+		"locked" if result["debug"]["locked"] else "unlocked",
+		"permanent" if result["debug"]["permanent"] else "not permanent",
+		result["debug"]["locks"], result["debug"]["unlocks"]))
+	print("Status:         %d" % result["status"])
+
+
+def provision_device(serial, workdir, params, timeout, session, log=None, timings=None,
+		images=()):
+	"""
+	Load and start the firmware on one device, then wait up to timeout seconds for its result.
+	With session, one in-process J-Link connection does it all, else J-Link Commander is run
+	for the load and for every poll. Returns (error message or None, result or None).
+	Host side (step, seconds) pairs are appended to timings, "wait" being the result polling.
+	images are programmed first in the same connection, see make_jlink_script().
+	"""
+	timings = [] if timings is None else timings
+	script = make_jlink_script(workdir, params, images)
+	if session:
+		jlink = jlink_session.JLinkSession(serial)
+		jlink.timings = timings
+		try:
+			with jlink:
+				jlink.run_script(script)
+				if not timeout:
+					return None, None
+				start = time.monotonic()
+				result = wait_result(lambda: jlink.read(RESULT_ADDRESS, RESULT_SIZE), timeout, 0.01)
+				timings.append(("wait", time.monotonic() - start))
+				return None, result
+		except (jlink_session.JLinkError, OSError, ValueError) as e:
+			if log:
+				log.write("%s\n" % e)
+			return str(e), None
+
+	start = time.monotonic()
+	ret = run_jlinkexe(serial, workdir, script, log)
+	timings.append(("jlinkexe", time.monotonic() - start))
+	if ret != 0:
+		return "J-Link Commander exit code %d" % ret, None
+	if not timeout:
+		return None, None
+	start = time.monotonic()
+	result = wait_result(lambda: read_result(serial, workdir), timeout, 0.2)
+	timings.append(("wait", time.monotonic() - start))
+	return None, result
+
+
+def gang_provision_one(serial, outdir, params, pub_key, timeout, session, images):
+	workdir = os.path.join(outdir, serial)
+	os.makedirs(workdir, exist_ok=True)
+	log = os.path.join(workdir, "jlink.log")
+
+	start = time.monotonic()
+	with open(log, "w") as f:
+		error, result = provision_device(serial, workdir, params, timeout, session, f,
+			images=images)
+	# Without a result block to read back there is nothing to judge, only load errors fail
+	if error is not None:
+		outcome = "FAIL"
+	elif timeout:
+		outcome = "PASS" if result_passed(result, pub_key) else "FAIL"
+	else:
+		outcome = "NO RESULT"
+	return {"serial": serial, "passed": outcome != "FAIL", "outcome": outcome, "error": error,
+		"time": time.monotonic() - start, "log": log, "usn": result["usn"] if result else "-"}
+
+
+def gang_provision(serials, outdir, params, pub_key, timeout, session, images=()):
+	"""
+	Provision one device per probe, all at the same time, returns one result per probe.
+	With a timeout, a device passes only on a good result block read back from it. Without
+	one, a device that loaded and started is reported as NO RESULT, which is not a failure.
+	"""
+	start = time.monotonic()
+	with ThreadPoolExecutor(max_workers=len(serials)) as pool:
+		results = list(pool.map(lambda serial: gang_provision_one(serial, outdir, params, pub_key,
+			timeout, session, images), serials))
+	elapsed = time.monotonic() - start
+
+	print("\n%-12s %-9s %8s  %-26s  %s" % ("Probe", "Result", "Time (s)", "USN", "Log"))
+	for r in results:
+		print("%-12s %-9s %8.1f  %-26s  %s" % (r["serial"], r["outcome"], r["time"], r["usn"],
+			r["log"]))
+	passed = sum(r["outcome"] == "PASS" for r in results)
+	unchecked = sum(r["outcome"] == "NO RESULT" for r in results)
+	print("\n%d/%d passed%s in %.1f s, %.1f devices/minute" % (passed, len(results),
+		", %d started without a result block" % unchecked if unchecked else "", elapsed,
+		60.0 * len(results) / elapsed if elapsed else 0.0))
+	return results
 
 
 if __name__ == '__main__':
 	parser = argparse.ArgumentParser(description='Parameters need to be passed')
 
 	parser.add_argument("-c", "--cert", dest="cert_file", help="Cerfitifcate FILE", metavar="FILE")
+	parser.add_argument("--gang", action="store_true",
+		help="provision one device on every attached J-Link probe at the same time")
+	parser.add_argument("--probes", help="comma separated probe serial numbers to use with --gang")
+	parser.add_argument("--outdir", default="gang_logs",
+		help="per probe scripts and logs for --gang, in <outdir>/<serial>")
+	parser.add_argument("-y", "--yes", action="store_true", help="do not ask for confirmation")
+	parser.add_argument("--lock", choices=LOCK_POLICIES.keys(), default="permanent",
+		help="after writing the key: leave the debug port (none), lock it (debug) "
+		"or lock and freeze it (permanent, the default)")
+	parser.add_argument("--command-mode", action="store_true",
+		help="start the firmware in command mode instead of provisioning, see bl1_command.py")
+	parser.add_argument("--test-menu", action="store_true", help="enter the test menu when done")
+	parser.add_argument("--legacy-elf-patch", action="store_true",
+		help="write the key into the .pubkey section of bl1_provision.elf instead of the mailbox")
+	parser.add_argument("--timeout", type=float, default=10.0,
+		help="seconds to wait for the result block read back over SWD, 0 to not wait")
+	parser.add_argument("--image", action="append", default=[], metavar="FILE[@ADDRESS]",
+		help="signed final firmware to program into flash in the same J-Link connection, "
+		".hex or .elf, or .bin@<address>; can be repeated")
+	parser.add_argument("--jlinkexe", action="store_true",
+		help="run J-Link Commander for every step instead of one in-process J-Link session")
 
 	args = parser.parse_args()
 
@@ -74,6 +392,13 @@ if __name__ == '__main__':
 		print(args)
 		sys.exit(1)
 
+	# Firmware built before the mailbox only takes the key, patched into its .pubkey section
+	legacy_elf_patch = args.legacy_elf_patch or not elf_has_mailbox(PROVISION_ELF)
+	if legacy_elf_patch and (args.lock != "permanent" or args.command_mode or args.test_menu):
+		print("%s has no parameter mailbox: --lock %s, --command-mode and --test-menu need the "
+			"firmware rebuilt from src/max32657_bl1_provision." % (PROVISION_ELF, args.lock))
+		sys.exit(1)
+
 	print("\n\033[91mWARNING:\033[0m")
 	print("This script will enable Secure Boot mode")
 	print("which will write your public key in the OTP and turn off debug interface")
@@ -81,16 +406,76 @@ if __name__ == '__main__':
 	print("After that device will not be reprogrammed!")
 	print("Be sure you write your final images on the device.\n")
 
-	response = input("Do you want to continue? (Y/N): ").strip().upper()
-	if response not in ['Y', "YES"]:
-		print("Operation aborted.")
-		sys.exit(0)
+	if args.gang:
+		serials = args.probes.split(",") if args.probes else list_probes()
+		if not serials:
+			print("No J-Link probe found.")
+			sys.exit(1)
+		print("Probes: " + ", ".join(serials))
+
+	if not args.yes:
+		response = input("Do you want to continue? (Y/N): ").strip().upper()
+		if response not in ['Y', "YES"]:
+			print("Operation aborted.")
+			sys.exit(0)
 
 	print("\n-------------------------")
-	elf_file = "bl1_provision.elf"
-	update_section_in_elf(args.cert_file, elf_file, '.pubkey')
-	print(".pubkey section updated")
+	if legacy_elf_patch:
+		if not args.legacy_elf_patch:
+			print("%s has no parameter mailbox, writing the key into its .pubkey section" %
+				PROVISION_ELF)
+		update_section_in_elf(args.cert_file, PROVISION_ELF, '.pubkey')
+		print(".pubkey section updated")
+		params = None
+	else:
+		# The ELF stays untouched, the key and policy go to the SRAM mailbox
+		flags = (FLAG_COMMAND_MODE if args.command_mode else 0) | (FLAG_TEST_MENU if args.test_menu else 0)
+		params = build_params(public_key(args.cert_file), LOCK_POLICIES[args.lock], flags)
+		print("Parameters: %d bytes for the mailbox at 0x%08X, lock policy %s" %
+			(len(params), PARAMS_ADDRESS, args.lock))
  
+	# In command mode the result is only final after the station sends "exit"
+	timeout = 0 if args.command_mode else args.timeout
+	has_result = elf_has_result_block(PROVISION_ELF)
+	if timeout and not has_result:
+		print("%s has no result block, check the outcome on the console UART." % PROVISION_ELF)
+		timeout = 0
+	pub_key = public_key(args.cert_file)
+	images = [parse_image(image) for image in args.image]
+	for path, address in images:
+		if not os.path.exists(path):
+			print("Image %s not found." % path)
+			sys.exit(1)
+		if path.lower().endswith(".bin") and address is None:
+			print("Image %s needs a load address, e.g. %s@0x01000000." % (path, path))
+			sys.exit(1)
+		print("Final image: " + path)
+	session = not args.jlinkexe and jlink_session.available()
+	if not args.jlinkexe and not session:
+		print("pylink not installed (pip install pylink-square), running J-Link Commander instead")
+
 	print("\n-------------------------")
-	bl1_provision()
+	if args.gang:
+		results = gang_provision(serials, os.path.abspath(args.outdir), params, pub_key, timeout,
+			session, images)
+		sys.exit(0 if all(r["passed"] for r in results) else 1)
+
+	with tempfile.TemporaryDirectory() as workdir:
+		error, result = provision_device(None, workdir, params, timeout, session, images=images)
+	if error:
+		print("bl1 provision FAILED: " + error)
+		sys.exit(1)
+	if not timeout:
+		print("bl1 provision started, no result block to check." if not has_result else
+			"bl1 provision done.")
+		sys.exit(0)
+
+	print("\n-------------------------")
+	if result is None:
+		print("No result from the firmware within %.0f s." % timeout)
+		sys.exit(2)
+	print_result(result, pub_key)
+	if not result_passed(result, pub_key):
+		print("bl1 provision FAILED.")
+		sys.exit(1)
 	print("bl1 provision done.")
@@ -0,0 +1,126 @@
+#-------------------------------------------------------------------------------
+# Copyright (C) 2025 Analog Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+#
+# One J-Link connection kept open in-process for a whole provisioning run, through the
+# J-Link DLL bindings (pip install pylink-square). It runs the same JLinkScript files as
+# J-Link Commander, then stays connected so the result can be read back without
+# starting, enumerating and connecting again.
+#
+import os
+import time
+
+try:
+	import pylink
+	JLinkError = pylink.errors.JLinkException
+except ImportError:
+	pylink = None
+	JLinkError = RuntimeError
+
+# ARM_REG_R15 of the J-Link DLL
+REG_PC = 15
+
+
+def available():
+	"""True when the J-Link DLL bindings are installed"""
+	return pylink is not None
+
+
+class JLinkSession:
+	def __init__(self, serial=None, device="MAX32657", speed=2000):
+		self.serial = serial
+		self.device = device
+		self.speed = speed
+		self.jlink = None
+		# (step, seconds) of open, connect and every script command, see benchmark.py
+		self.timings = []
+
+	def timed(self, step, start):
+		self.timings.append((step, time.monotonic() - start))
+
+	def __enter__(self):
+		self.open()
+		return self
+
+	def __exit__(self, *exc):
+		self.close()
+
+	def open(self):
+		# Each JLink object loads its own copy of the DLL, so several probes can run in threads
+		start = time.monotonic()
+		self.jlink = pylink.JLink()
+		self.jlink.open(serial_no=int(self.serial) if self.serial else None)
+		self.timed("open", start)
+		start = time.monotonic()
+		self.jlink.set_tif(pylink.enums.JLinkInterfaces.SWD)
+		self.jlink.connect(self.device, speed=self.speed)
+		self.timed("connect", start)
+
+	def close(self):
+		if self.jlink is not None:
+			self.jlink.close()
+			self.jlink = None
+
+	def read(self, address, length):
+		"""Read target memory, the core keeps running"""
+		return bytes(self.jlink.memory_read8(address, length))
+
+	def write(self, address, data):
+		self.jlink.memory_write8(address, list(data))
+
+	def run_script(self, script):
+		"""
+		Run the J-Link Commander commands of a JLinkScript file: h, r, loadfile, loadbin,
+		w4, SetPC, g, Sleep and q. Relative paths are taken from the script folder.
+		"""
+		folder = os.path.dirname(os.path.abspath(script))
+		with open(script) as f:
+			for number, line in enumerate(f, 1):
+				words = line.split("//")[0].split()
+				if not words:
+					continue
+				try:
+					start = time.monotonic()
+					done = self.command(words[0].lower(), words[1:], folder) is False
+					self.timed(words[0].lower(), start)
+					if done:
+						break
+				except (IndexError, ValueError):
+					raise ValueError("%s:%d: cannot run '%s'" % (script, number, line.strip()))
+
+	def command(self, name, args, folder):
+		"""One JLinkScript command, returns False for q"""
+		if name in ("h", "halt"):
+			self.jlink.halt()
+		elif name in ("r", "reset"):
+			self.jlink.reset(halt=True)
+		elif name in ("loadfile", "loadbin"):
+			# The DLL takes .elf, .hex and .bin, into flash or RAM
+			path = os.path.join(folder, args[0])
+			address = int(args[1], 16) if len(args) > 1 else 0
+			self.jlink.flash_file(path, address)
+		elif name in ("w4", "mem32write"):
+			self.jlink.memory_write32(int(args[0], 16), [int(args[1], 16)])
+		elif name == "setpc":
+			self.jlink.register_write(REG_PC, int(args[0], 16))
+		elif name in ("g", "go"):
+			self.jlink.restart()
+		elif name == "sleep":
+			time.sleep(int(args[0]) / 1000.0)
+		elif name in ("q", "qc", "exit"):
+			return False
+		else:
+			raise ValueError("unsupported command")
+		return True
@@ -0,0 +1,285 @@
+#-------------------------------------------------------------------------------
+# Copyright (C) 2025 Analog Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+#
+# Decode the binary dump frames sent by the firmware once "Toggle Binary Dump Mode"
+# is selected in the test menu.
+#
+# Wire format: 0x00, COBS(type, sequence, payload, CRC32 little endian), 0x00
+# where CRC32 is zlib's over type, sequence and payload. A dump is a BEGIN frame
+# (address, length, name), DATA frames (address, data) and an END frame holding
+# the CRC32 of all the block data. With compressed dumps enabled, runs of one byte
+# value come as FILL frames (address, length, value) instead of DATA frames.
+#
+# Firmware built with TERMINAL_DEFERRED_LOG sends its status messages as LOG frames
+# (format ID, arguments). The format strings are read back from the .tlog_fmt section
+# of the ELF given with --elf.
+#
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+FRAME_BEGIN = 0x01
+FRAME_DATA = 0x02
+FRAME_END = 0x03
+FRAME_FILL = 0x04
+FRAME_LOG = 0x05
+
+# printf conversions used by TERMINAL_LOG(), length modifiers are ignored
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t)?([diouxXcsp%])")
+
+# Layout of max32657_otp_nv_counters_region_t in bl2_info.c
+BL2_PARAMS_FIELDS = [
+	("huk", 32), ("iak", 32), ("iak_len", 4), ("iak_type", 4), ("iak_id", 32),
+	("boot_seed", 32), ("lcs", 4), ("implementation_id", 32), ("cert_ref", 32),
+	("verification_service_url", 32), ("profile_definition", 32),
+	("bl2_rotpk_0", 100), ("bl2_rotpk_1", 100), ("bl2_rotpk_2", 100), ("bl2_rotpk_3", 100),
+	("bl2_nv_counter_0", 64), ("bl2_nv_counter_1", 64), ("bl2_nv_counter_2", 64),
+	("bl2_nv_counter_3", 64),
+	("ns_nv_counter_0", 64), ("ns_nv_counter_1", 64), ("ns_nv_counter_2", 64),
+	("entropy_seed", 64), ("secure_debug_pk", 32),
+]
+
+
+def cobs_decode(data):
+	out = bytearray()
+	i = 0
+	while i < len(data):
+		code = data[i]
+		if code == 0 or i + code > len(data):
+			return None
+		out += data[i + 1:i + code]
+		i += code
+		if code < 0xFF and i < len(data):
+			out.append(0)
+	return bytes(out)
+
+
+def parse_frame(chunk):
+	"""Return (type, sequence, payload) or None if chunk is not a valid frame"""
+	frame = cobs_decode(chunk)
+	if frame is None or len(frame) < 6:
+		return None
+	body, crc = frame[:-4], struct.unpack("<I", frame[-4:])[0]
+	if zlib.crc32(body) != crc:
+		return None
+	return body[0], body[1], body[2:]
+
+
+class LogFormats:
+	"""Format strings of TERMINAL_LOG() messages, by format ID"""
+	def __init__(self, elf_file):
+		from elftools.elf.elffile import ELFFile
+
+		with open(elf_file, "rb") as f:
+			section = ELFFile(f).get_section_by_name(".tlog_fmt")
+			if section is None:
+				raise RuntimeError("%s has no .tlog_fmt section, not a TERMINAL_DEFERRED_LOG build"
+					% elf_file)
+			self.data = section.data()
+			# Zero on target where the section is not loaded, the link address on a host build
+			self.base = section["sh_addr"]
+
+	def format(self, fid, args):
+		offset = fid - self.base
+		end = self.data.find(b"\x00", offset)
+		if offset < 0 or end < 0:
+			return "[unknown log format 0x%08x] %s\r\n" % (fid, args.hex())
+		return printf(self.data[offset:end].decode("ascii", "replace"), args)
+
+
+def printf(fmt, args):
+	"""Format the raw arguments of a LOG frame: integers as le32, strings NUL terminated"""
+	out = []
+	pos = 0
+	offset = 0
+	for match in CONVERSION.finditer(fmt):
+		out.append(fmt[pos:match.start()])
+		pos = match.end()
+		flags, width, precision, conv = match.groups()
+		if conv == "%":
+			out.append("%")
+			continue
+
+		try:
+			if conv == "s":
+				end = args.index(b"\x00", offset)
+				value = args[offset:end].decode("ascii", "replace")
+				offset = end + 1
+			else:
+				value = struct.unpack_from("<i" if conv in "di" else "<I", args, offset)[0]
+				offset += 4
+				conv = {"i": "d", "u": "d", "p": "x"}.get(conv, conv)
+		except (ValueError, struct.error):
+			out.append("<truncated>")
+			break
+		out.append(("%" + flags + width + ("." + precision if precision else "") + conv) % value)
+	else:
+		out.append(fmt[pos:])
+	return "".join(out)
+
+
+class BlockDecoder:
+	def __init__(self, outdir, verbose, formats=None):
+		self.outdir = outdir
+		self.verbose = verbose
+		self.formats = formats
+		self.sequence = None
+		self.block = None
+		self.blocks = []
+		self.errors = 0
+
+	def text(self, chunk):
+		if self.verbose:
+			sys.stdout.write(chunk.decode("ascii", "replace"))
+
+	def error(self, message):
+		self.errors += 1
+		print("error: " + message, file=sys.stderr)
+
+	def frame(self, ftype, sequence, payload):
+		if self.sequence is not None and sequence != (self.sequence + 1) & 0xFF:
+			self.error("frame lost before sequence %d" % sequence)
+		self.sequence = sequence
+
+		if ftype == FRAME_LOG:
+			self.log(struct.unpack("<I", payload[:4])[0], payload[4:])
+		elif ftype == FRAME_BEGIN:
+			address, length = struct.unpack("<II", payload[:8])
+			self.block = {"name": payload[8:].decode("ascii"), "address": address,
+				"length": length, "data": bytearray(length), "received": 0}
+		elif self.block is None:
+			self.error("frame type %d outside of a block" % ftype)
+		elif ftype == FRAME_DATA:
+			self.store(struct.unpack("<I", payload[:4])[0], payload[4:])
+		elif ftype == FRAME_FILL:
+			address, length, value = struct.unpack("<IIB", payload[:9])
+			if length > self.block["length"]:
+				self.error("fill of %d bytes larger than block %s" % (length, self.block["name"]))
+				return
+			self.store(address, bytes([value]) * length)
+		elif ftype == FRAME_END:
+			self.finish(struct.unpack("<I", payload[:4])[0])
+		else:
+			self.error("unknown frame type %d" % ftype)
+
+	def log(self, fid, args):
+		if self.formats is None:
+			sys.stdout.write("[log 0x%08x] %s\r\n" % (fid, args.hex()))
+		else:
+			sys.stdout.write(self.formats.format(fid, args))
+
+	def store(self, address, data):
+		offset = address - self.block["address"]
+		if offset < 0 or offset + len(data) > self.block["length"]:
+			self.error("data at 0x%08x outside of block %s" % (address, self.block["name"]))
+			return
+		self.block["data"][offset:offset + len(data)] = data
+		self.block["received"] += len(data)
+
+	def finish(self, crc):
+		block, self.block = self.block, None
+		data = bytes(block["data"])
+		if block["received"] != block["length"] or zlib.crc32(data) != crc:
+			self.error("block %s incomplete or corrupted" % block["name"])
+			return
+
+		self.blocks.append(block)
+		path = os.path.join(self.outdir, block["name"] + ".bin")
+		with open(path, "wb") as f:
+			f.write(data)
+		print("%-20s 0x%08x %6d bytes -> %s" % (block["name"], block["address"], len(data), path))
+
+		if block["name"] == "bl2_params" and self.verbose:
+			print_bl2_params(data)
+
+	def feed(self, stream):
+		pending = bytearray()
+		for chunk in stream:
+			pending += chunk
+			while True:
+				end = pending.find(b"\x00")
+				if end < 0:
+					break
+				piece, pending = bytes(pending[:end]), pending[end + 1:]
+				if not piece:
+					continue
+				parsed = parse_frame(piece)
+				if parsed is None:
+					self.text(piece)
+				else:
+					self.frame(*parsed)
+		if pending:
+			self.text(bytes(pending))
+
+
+def print_bl2_params(data):
+	offset = 0
+	for name, size in BL2_PARAMS_FIELDS:
+		value = data[offset:offset + size]
+		if size == 4:
+			print("  %-26s 0x%08X" % (name, struct.unpack("<I", value)[0]))
+		else:
+			print("  %-26s %s" % (name, value.hex().upper()))
+		offset += size
+
+
+def read_file(path):
+	f = sys.stdin.buffer if path == "-" else open(path, "rb")
+	while True:
+		chunk = f.read(4096)
+		if not chunk:
+			break
+		yield chunk
+
+
+def read_serial(port, baud, timeout):
+	import serial
+
+	with serial.Serial(port, baud, timeout=timeout) as ser:
+		while True:
+			chunk = ser.read(4096)
+			if not chunk:
+				# Quiet line, assume the dump is over
+				break
+			yield chunk
+
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser(description="Decode binary dump frames from the console UART")
+	source = parser.add_mutually_exclusive_group(required=True)
+	source.add_argument("--port", help="serial port to read, e.g. /dev/ttyUSB0 or COM3")
+	source.add_argument("--input", help="captured UART output to decode, - for stdin")
+	parser.add_argument("--baud", type=int, default=115200, help="serial baud rate")
+	parser.add_argument("--timeout", type=float, default=2.0,
+		help="stop reading the port after this many quiet seconds")
+	parser.add_argument("--outdir", default=".", help="where to write <block name>.bin")
+	parser.add_argument("-v", "--verbose", action="store_true",
+		help="echo text between frames and print decoded bl2 parameters")
+	parser.add_argument("--elf", help="firmware ELF, to print TERMINAL_DEFERRED_LOG messages")
+	args = parser.parse_args()
+
+	os.makedirs(args.outdir, exist_ok=True)
+	formats = LogFormats(args.elf) if args.elf else None
+	decoder = BlockDecoder(args.outdir, args.verbose, formats)
+	if args.port:
+		decoder.feed(read_serial(args.port, args.baud, args.timeout))
+	else:
+		decoder.feed(read_file(args.input))
+
+	sys.exit(1 if decoder.errors or decoder.block is not None else 0)
@@ -0,0 +1,89 @@
+#-------------------------------------------------------------------------------
+# Copyright (C) 2025 Analog Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+#
+# Rebuild binary images from a captured text dump. Rows look like
+#   0x<address>: xx xx xx ...
+# and, once "Toggle Compressed Dumps" is selected, rows repeating the row above
+# are collapsed into
+#   0x<first>-0x<last>: *
+# Every contiguous address range is written to <outdir>/dump_0x<address>.bin.
+#
+import argparse
+import os
+import re
+import sys
+
+ROW = re.compile(r"^0x([0-9a-fA-F]{8}):((?: [0-9a-fA-F]{2})+)\s*$")
+REPEAT = re.compile(r"^0x([0-9a-fA-F]{8})-0x([0-9a-fA-F]{8}): \*\s*$")
+
+
+def expand(lines):
+	"""Return a list of [address, bytearray] segments, raise ValueError on a bad capture"""
+	segments = []
+	row = None
+
+	def append(address, data):
+		if segments and segments[-1][0] + len(segments[-1][1]) == address:
+			segments[-1][1] += data
+		else:
+			segments.append([address, bytearray(data)])
+
+	for number, line in enumerate(lines, 1):
+		line = line.strip()
+		if not line:
+			# Rows end with "\n\r", which reads as an empty line in between
+			continue
+
+		match = ROW.match(line)
+		if match:
+			row = bytes.fromhex(match.group(2))
+			append(int(match.group(1), 16), row)
+			continue
+
+		match = REPEAT.match(line)
+		if match:
+			first, last = int(match.group(1), 16), int(match.group(2), 16)
+			length = last - first + 1
+			if row is None or length <= 0 or length % len(row):
+				raise ValueError("line %d: repeat marker without a matching row above" % number)
+			append(first, row * (length // len(row)))
+			continue
+
+		# Anything else (menus, titles) ends the row a marker can refer to
+		row = None
+
+	return segments
+
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser(description="Rebuild binary images from a text dump capture")
+	parser.add_argument("--input", required=True, help="captured UART output, - for stdin")
+	parser.add_argument("--outdir", default=".", help="where to write dump_0x<address>.bin")
+	args = parser.parse_args()
+
+	f = sys.stdin if args.input == "-" else open(args.input, "r", errors="replace")
+	try:
+		segments = expand(f.read().splitlines())
+	except ValueError as e:
+		print("error: %s" % e, file=sys.stderr)
+		sys.exit(1)
+
+	os.makedirs(args.outdir, exist_ok=True)
+	for address, data in segments:
+		path = os.path.join(args.outdir, "dump_0x%08x.bin" % address)
+		with open(path, "wb") as out:
+			out.write(data)
+		print("0x%08x %6d bytes -> %s" % (address, len(data), path))
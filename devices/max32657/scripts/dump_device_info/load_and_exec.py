@@ -14,15 +14,32 @@
 # limitations under the License.
 #-------------------------------------------------------------------------------
 import os
+import sys
+import argparse
 
+# In-process J-Link session shared with the provisioning script
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "bl1_provision"))
+import jlink_session
 
-def load_and_exec():
-	# Execute JLink Script
+
+def load_and_exec(probe=None, session=False):
+	# Execute JLink Script, on the given probe serial number when several are attached
+	if session:
+		with jlink_session.JLinkSession(probe) as jlink:
+			jlink.run_script("JLinkScript")
+		return
 	JLinkExe = "JLink" if os.name == "nt" else "JLinkExe"
-	os.system(JLinkExe + " -device MAX32657 -if swd -speed 2000 -autoconnect 1 -CommanderScript JLinkScript")
+	usb = " -USB " + probe if probe else ""
+	os.system(JLinkExe + usb + " -device MAX32657 -if swd -speed 2000 -autoconnect 1 -CommanderScript JLinkScript")
 
 
 if __name__ == '__main__':
+	parser = argparse.ArgumentParser(description="Load and run dump_device_info.elf")
+	parser.add_argument("--probe", help="J-Link serial number, needed when several probes are attached")
+	parser.add_argument("--jlinkexe", action="store_true",
+		help="run J-Link Commander even when pylink is installed")
+	args = parser.parse_args()
+
 	print("\n-------------------------")
-	load_and_exec()
+	load_and_exec(args.probe, jlink_session.available() and not args.jlinkexe)
 	print("\nImage loaded, check the PC comport")
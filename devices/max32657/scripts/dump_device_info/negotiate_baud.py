@@ -0,0 +1,104 @@
+#-------------------------------------------------------------------------------
+# Copyright (C) 2025 Analog Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+#
+# Move the console UART to a faster baud rate. Selects "Negotiate Baud Rate" in the
+# test menu, picks the fastest rate offered by the firmware that the adapter allows,
+# and confirms it with a test pattern. Both sides stay on the old rate on any error.
+#
+import argparse
+import re
+import sys
+import time
+
+import serial
+
+PATTERN = bytes([0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0, 0x33, 0xCC])
+MENU_ENTRY = "Negotiate Baud Rate"
+
+
+def read_until(ser, pattern, timeout, data=b""):
+	"""Read until the regular expression matches what was received, return the match"""
+	deadline = time.monotonic() + timeout
+	while time.monotonic() < deadline:
+		data += ser.read(ser.in_waiting or 1)
+		match = re.search(pattern, data)
+		if match:
+			return match
+	raise TimeoutError("no %s from target" % pattern.decode())
+
+
+def select_menu_entry(ser, timeout):
+	# An empty selection makes the menu print itself again
+	ser.reset_input_buffer()
+	ser.write(b"\r")
+	menu = read_until(ser, rb"(?s).*Please select:", timeout).group(0)
+	match = re.search(rb"(\d+)\s*-\s*" + MENU_ENTRY.encode(), menu)
+	if match is None:
+		raise RuntimeError("firmware has no '%s' menu entry" % MENU_ENTRY)
+	ser.write(match.group(1) + b"\r")
+
+
+def negotiate(ser, max_baud, timeout=2.0):
+	"""Run the handshake on an open port, returns the baud rate in use afterwards"""
+	old_baud = ser.baudrate
+
+	offer = read_until(ser, rb"BAUD-OFFER([ 0-9]*)\r\n", timeout)
+	rates = [int(r) for r in offer.group(1).split()]
+	candidates = [r for r in rates if r <= max_baud]
+	if not candidates:
+		ser.write(b"\x1b")
+		raise RuntimeError("no common rate, target offers %s" % rates)
+	baud = max(candidates)
+
+	ser.write(b"%d\r" % baud)
+	reply = read_until(ser, rb"BAUD-OK %d\r\n|BAUD-FAIL" % baud, timeout)
+	if reply.group(0) == b"BAUD-FAIL":
+		raise RuntimeError("target refused %d" % baud)
+
+	ser.baudrate = baud
+	# Let the target finish switching before talking at the new rate
+	time.sleep(0.05)
+	ser.reset_input_buffer()
+	ser.write(PATTERN)
+	echo = ser.read(len(PATTERN))
+	if echo != PATTERN:
+		# Stay quiet, the target times out and goes back to the old rate
+		ser.baudrate = old_baud
+		read_until(ser, rb"BAUD-FAIL", timeout + 1.0, echo)
+		raise RuntimeError("test pattern failed at %d, back to %d" % (baud, old_baud))
+
+	ser.write(b"\r")
+	return baud
+
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser(description="Negotiate a faster console UART baud rate")
+	parser.add_argument("--port", required=True, help="serial port, e.g. /dev/ttyUSB0 or COM3")
+	parser.add_argument("--baud", type=int, default=115200, help="current baud rate")
+	parser.add_argument("--max-baud", type=int, default=3000000,
+		help="fastest rate the USB-UART adapter supports")
+	parser.add_argument("--timeout", type=float, default=2.0, help="seconds to wait for each reply")
+	args = parser.parse_args()
+
+	with serial.Serial(args.port, args.baud, timeout=args.timeout) as ser:
+		try:
+			select_menu_entry(ser, args.timeout)
+			baud = negotiate(ser, args.max_baud, args.timeout)
+		except (RuntimeError, TimeoutError) as e:
+			print("error: %s" % e, file=sys.stderr)
+			sys.exit(1)
+
+	print("Console UART now at %d baud, use --baud %d with decode_frames.py" % (baud, baud))
@@ -0,0 +1,118 @@
+#-------------------------------------------------------------------------------
+# Copyright (C) 2025 Analog Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#-------------------------------------------------------------------------------
+#
+# ECDSA P-256 / SHA-256 signing backends for sign_app.py. Every backend takes a PEM
+# private key and produces the same raw signature format, r || s as two 32 byte big
+# endian integers, so signatures from one verify with any other.
+#
+#   cryptography    OpenSSL through the cryptography package, the default
+#   ecdsa           pure Python ecdsa package, the fallback
+#
+import hashlib
+
+try:
+	import ecdsa
+except ImportError:
+	ecdsa = None
+
+try:
+	from cryptography.exceptions import InvalidSignature
+	from cryptography.hazmat.primitives import hashes, serialization
+	from cryptography.hazmat.primitives.asymmetric import ec
+	from cryptography.hazmat.primitives.asymmetric.utils import (Prehashed,
+		decode_dss_signature, encode_dss_signature)
+except ImportError:
+	ec = None
+
+COORDINATE_SIZE = 32
+
+
+class CryptographyBackend:
+	name = "cryptography"
+
+	def __init__(self, pem):
+		self.key = serialization.load_pem_private_key(pem.encode(), password=None)
+		if not isinstance(self.key.curve, ec.SECP256R1):
+			raise ValueError("the key is not a prime256v1 (P-256) key")
+		self.algorithm = ec.ECDSA(Prehashed(hashes.SHA256()))
+
+	def sign_digest(self, digest):
+		r, s = decode_dss_signature(self.key.sign(digest, self.algorithm))
+		return r.to_bytes(COORDINATE_SIZE, "big") + s.to_bytes(COORDINATE_SIZE, "big")
+
+	def verify_digest(self, signature, digest):
+		r = int.from_bytes(signature[:COORDINATE_SIZE], "big")
+		s = int.from_bytes(signature[COORDINATE_SIZE:], "big")
+		try:
+			self.key.public_key().verify(encode_dss_signature(r, s), digest, self.algorithm)
+		except InvalidSignature:
+			return False
+		return True
+
+	def public_key(self):
+		"""Raw X || Y"""
+		return self.key.public_key().public_bytes(serialization.Encoding.X962,
+			serialization.PublicFormat.UncompressedPoint)[1:]
+
+
+class EcdsaBackend:
+	name = "ecdsa"
+
+	def __init__(self, pem):
+		self.key = ecdsa.SigningKey.from_pem(pem, hashfunc=hashlib.sha256)
+		if self.key.curve != ecdsa.NIST256p:
+			raise ValueError("the key is not a prime256v1 (P-256) key")
+
+	def sign_digest(self, digest):
+		return self.key.sign_digest(digest)
+
+	def verify_digest(self, signature, digest):
+		try:
+			return self.key.verifying_key.verify_digest(signature, digest)
+		except ecdsa.BadSignatureError:
+			return False
+
+	def public_key(self):
+		"""Raw X || Y"""
+		return self.key.verifying_key.to_string()
+
+
+# In order of preference
+BACKENDS = {"cryptography": CryptographyBackend, "ecdsa": EcdsaBackend}
+
+
+def available():
+	"""Names of the backends whose package is installed, preferred first"""
+	installed = {"cryptography": ec is not None, "ecdsa": ecdsa is not None}
+	return [name for name in BACKENDS if installed[name]]
+
+
+def pick(name=None):
+	"""Backend load() uses: name if it is installed, else the preferred installed one"""
+	names = available()
+	if not names:
+		raise RuntimeError("no ECDSA backend, pip install cryptography (or ecdsa)")
+	if name is None:
+		return names[0]
+	if name not in names:
+		raise RuntimeError("ECDSA backend '%s' is not installed" % name)
+	return name
+
+
+def load(pem, name=None):
+	"""Signer for a PEM private key, with the named backend or the preferred installed one"""
+	return BACKENDS[pick(name)](pem)
@@ -16,45 +16,240 @@
 #-------------------------------------------------------------------------------
 
 import argparse
-import ecdsa
 import hashlib
+import json
+import os
+import sys
+import time
+from concurrent.futures import ProcessPoolExecutor
 
+import ecdsa_backend
 
-def sign_ecdsa(infile, outfile, certfile):
-	with open(infile, 'rb') as f:
-		bin_file = f.read()
+CHUNK_SIZE = 1 << 20
+DEFAULT_CACHE = os.path.join(os.environ.get("XDG_CACHE_HOME", os.path.expanduser("~/.cache")),
+	"sign_app")
 
+# Key and cache folder of each worker process of a batch, set once by sign_worker_init()
+worker_key = None
+worker_cache = None
+
+
+def load_key(certfile, backend=None):
 	with open(certfile, 'r') as f:
 		cert_data = f.read()
 
-	sk = ecdsa.SigningKey.from_pem(cert_data, hashfunc=hashlib.sha256)
-	sig = sk.sign(bin_file, hashfunc=hashlib.sha256)
+	return ecdsa_backend.load(cert_data, backend)
+
+
+def copy_and_hash(infile, outfile):
+	"""Copy infile to outfile a chunk at a time, returns (size, SHA-256 digest)"""
+	digest = hashlib.sha256()
+	size = 0
+	with open(infile, 'rb') as fin, open(outfile, 'wb') as fout:
+		while True:
+			chunk = fin.read(CHUNK_SIZE)
+			if not chunk:
+				break
+			digest.update(chunk)
+			fout.write(chunk)
+			size += len(chunk)
+	return size, digest.digest()
+
+
+def cache_path(cache, sk, digest):
+	"""Cached signature of an image, keyed by the image SHA-256 and the public key fingerprint"""
+	fingerprint = hashlib.sha256(sk.public_key()).hexdigest()[:16]
+	return os.path.join(cache, fingerprint, digest.hex() + ".sig")
+
+
+def cache_store(path, sig):
+	# Through a rename, so parallel builds never read half an entry
+	os.makedirs(os.path.dirname(path), exist_ok=True)
+	tmp = "%s.%d.tmp" % (path, os.getpid())
+	with open(tmp, 'wb') as f:
+		f.write(sig)
+	os.replace(tmp, path)
+
+
+def sign_image(sk, infile, outfile, cache=None):
+	"""
+	Write infile followed by its raw (r || s) signature to outfile, returns a report entry.
+	The signature comes from the cache when the same image was signed with the same key.
+	Cached or fresh, it is verified before outfile is written; outfile is left alone on error.
+	"""
+	start = time.monotonic()
+	tmp = outfile + ".tmp"
+	size, digest = copy_and_hash(infile, tmp)
 
-	#vk = sk.verifying_key
-	#vk.verify(sig, bin_file, hashfunc=hashlib.sha256)
+	path = cache_path(cache, sk, digest) if cache else None
+	sig = None
+	if path and os.path.exists(path):
+		with open(path, 'rb') as f:
+			sig = f.read()
+		# A damaged entry is signed again and replaced
+		if not sk.verify_digest(sig, digest):
+			sig = None
+	cached = sig is not None
 
-	print("\nGenerated Signature:")
-	print(sig.hex())
+	if not cached:
+		sig = sk.sign_digest(digest)
+		if not sk.verify_digest(sig, digest):
+			os.remove(tmp)
+			raise RuntimeError(f"signature of {infile} does not verify")
+		if path:
+			cache_store(path, sig)
 
-	with open(outfile, 'wb') as f:
-		f.write(bin_file)
+	with open(tmp, 'ab') as f:
 		f.write(sig)
+	os.replace(tmp, outfile)
+
+	return {"input": infile, "output": outfile, "size": size, "sha256": digest.hex(),
+		"signature": sig.hex(), "cached": cached, "seconds": time.monotonic() - start}
+
+
+def sign_ecdsa(infile, outfile, certfile, backend=None, cache=None):
+	sk = load_key(certfile, backend)
+	result = sign_image(sk, infile, outfile, cache)
+
+	print(f"\n{'Cached' if result['cached'] else 'Generated'} Signature ({sk.name}, verified):")
+	print(result["signature"])
+
+	return result
+
+
+def sign_worker_init(cert_data, backend, cache):
+	global worker_key, worker_cache
+	worker_key = ecdsa_backend.load(cert_data, backend)
+	worker_cache = cache
+
+
+def sign_worker(job):
+	return sign_image(worker_key, job["input"], job["output"], worker_cache)
+
+
+def read_manifest(manifest):
+	"""
+	Images to sign, a JSON list of {"input": ..., "output": ...}.
+	Relative paths are taken from the manifest folder.
+	"""
+	folder = os.path.dirname(os.path.abspath(manifest))
+	with open(manifest) as f:
+		entries = json.load(f)
+	return [{key: os.path.join(folder, entry[key]) for key in ("input", "output")} for entry in entries]
+
+
+def sign_batch(jobs, certfile, workers=None, backend=None, cache=None):
+	"""Sign every image across a process pool, returns one report entry per image, in order"""
+	with open(certfile, 'r') as f:
+		cert_data = f.read()
+
+	with ProcessPoolExecutor(max_workers=workers, initializer=sign_worker_init,
+			initargs=(cert_data, backend, cache)) as pool:
+		return list(pool.map(sign_worker, jobs))
+
+
+def benchmark(certfile, count):
+	"""
+	Sign and verify count digests with every installed backend, then check the signatures
+	of each backend with all the others. Returns False if any check failed.
+	"""
+	with open(certfile, 'r') as f:
+		cert_data = f.read()
+
+	digest = hashlib.sha256(b"sign_app benchmark").digest()
+	signers = [ecdsa_backend.load(cert_data, name) for name in ecdsa_backend.available()]
+	signatures = {}
+	ok = True
+
+	print(f"{'Backend':<14} {'sign/s':>10} {'verify/s':>10}")
+	for sk in signers:
+		start = time.perf_counter()
+		signatures[sk.name] = [sk.sign_digest(digest) for _ in range(count)]
+		signing = time.perf_counter() - start
+
+		start = time.perf_counter()
+		ok = all([sk.verify_digest(sig, digest) for sig in signatures[sk.name]]) and ok
+		verifying = time.perf_counter() - start
+		print(f"{sk.name:<14} {count / signing:>10.1f} {count / verifying:>10.1f}")
+
+	for sk in signers:
+		for other in signers:
+			if other is sk:
+				continue
+			same_key = sk.public_key() == other.public_key()
+			verified = all(other.verify_digest(sig, digest) for sig in signatures[sk.name])
+			print(f"{sk.name} signatures verified by {other.name}: "
+				f"{'yes' if same_key and verified else 'NO'}")
+			ok = ok and same_key and verified
+
+	return ok
 
 
 if __name__ == '__main__':
 
 	parser = argparse.ArgumentParser()
 
-	parser.add_argument("--input_file", help="the image to process", required=True)
+	parser.add_argument("--input_file", help="the image to process")
 	parser.add_argument("--sign_key_file", help="signing key file", required=False)
-	parser.add_argument("--img_output_file", help="image output file", required=True)
+	parser.add_argument("--img_output_file", help="image output file")
+	parser.add_argument("--manifest", help="JSON list of {\"input\": ..., \"output\": ...} to sign in one run")
+	parser.add_argument("--jobs", type=int, default=None, help="worker processes for --manifest, default one per core")
+	parser.add_argument("--report", help="write the digest and signature of every image to this JSON file")
+	parser.add_argument("--backend", choices=ecdsa_backend.BACKENDS.keys(),
+		help="ECDSA implementation, default the first installed of " + ", ".join(ecdsa_backend.BACKENDS))
+	parser.add_argument("--benchmark", type=int, metavar="N",
+		help="sign N digests with every installed backend and report signatures per second")
+	parser.add_argument("--cache", default=DEFAULT_CACHE,
+		help="folder of signatures by image and key, reused for unchanged images (default %(default)s)")
+	parser.add_argument("--no-cache", action="store_true", help="always sign, do not use the cache")
 	args = parser.parse_args()
+	cache = None if args.no_cache else args.cache
+
+	if args.benchmark:
+		sys.exit(0 if benchmark(args.sign_key_file, args.benchmark) else 1)
+
+	# Resolved here so both paths show it, without cryptography signing falls back to ecdsa
+	backend = ecdsa_backend.pick(args.backend)
+	if args.backend is None and backend != "cryptography":
+		print("cryptography is not installed (pip install cryptography), "
+			f"signing with the slower {backend} backend")
+
+	if args.manifest:
+		jobs = read_manifest(args.manifest)
+		print(f"Signing {len(jobs)} images from {args.manifest}")
+		print(f"Certificate: {args.sign_key_file}")
+		print(f"Backend:     {backend}")
+
+		start = time.monotonic()
+		results = sign_batch(jobs, args.sign_key_file, args.jobs, backend, cache)
+		elapsed = time.monotonic() - start
+
+		for r in results:
+			print(f"{r['output']}: {r['size']} bytes, sha256 {r['sha256']}"
+				f"{', cached' if r['cached'] else ''}")
+		print(f"\n{len(results)} images signed in {elapsed:.2f} s, "
+			f"{sum(r['cached'] for r in results)} from the cache")
+
+		if args.report:
+			with open(args.report, 'w') as f:
+				json.dump({"sign_key_file": args.sign_key_file, "backend": backend, "seconds": elapsed,
+					"images": results}, f, indent=2)
+		sys.exit(0)
+
+	if not args.input_file or not args.img_output_file:
+		parser.error("--input_file and --img_output_file are required without --manifest")
 
 	print("Signing:")
 	print(f"Input File:  {args.input_file}")
 	print(f"Certificate: {args.sign_key_file}")
 	print(f"Output File: {args.img_output_file}")
+	print(f"Backend:     {backend}")
+
+	result = sign_ecdsa(args.input_file, args.img_output_file, args.sign_key_file, backend, cache)
 
-	sign_ecdsa(args.input_file, args.img_output_file, args.sign_key_file)
+	if args.report:
+		with open(args.report, 'w') as f:
+			json.dump({"sign_key_file": args.sign_key_file, "backend": backend, "images": [result]},
+				f, indent=2)
 
 	print("\nSignature Generation Succeeded")
@@ -0,0 +1,433 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+/*
+ * Host backend of the HAL.
+ *
+ * The 16KB information block is kept in memory with OTP semantics:
+ *  - programming can only clear bits (1 -> 0), a 1 in the written data leaves the bit as it is
+ *  - a 128-bit flash word whose top bit (bit 127) is cleared refuses further programming
+ *  - the block must be unlocked before it is read or programmed
+ * USN and FMV are pre-seeded and their words write locked, like on a fresh part.
+ *
+ * Environment variables:
+ *  HAL_HOST_INFOBLOCK  binary image of the information block, loaded at start if it exists
+ *                      and saved at exit, so several runs can provision the same "part"
+ *  HAL_HOST_PUBKEY     raw 64 byte public key (X || Y) returned by hal_pubkey()
+ *  HAL_HOST_MAILBOX    parameter manifest placed in the mailbox, as loadbin would on target
+ *  HAL_HOST_RESULT     result block saved at exit, as the host would read it over SWD
+ *  HAL_HOST_STATS      when set, print access counters on stderr at exit
+ *
+ * The console UART is stdin/stdout. Attach a pty with e.g. socat to drive it from
+ * the same host tools used against the real UART.
+ */
+
+/*******************************      INCLUDES    ****************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+
+#include "hal.h"
+#include "infoblock.h"
+#include "mailbox.h"
+
+/*******************************      DEFINES     ****************************/
+#define HOST_PUBKEY_SIZE 64
+#define HOST_MAILBOX_PARAMS_SIZE 2048
+#define HOST_MAILBOX_RESULT_SIZE 2048
+#define HOST_USN_LINES 3
+#define HOST_UART_FIFO_SIZE 8
+
+/*******************************    Variables   ****************************/
+static const uint8_t host_usn[HOST_USN_LINES * (INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD)] = {
+    0x05, 0x00, 0xAB, 0xCD, 0xEF, 0x01, 0x00, 0x01, 0x02,
+    0xAB, 0xCD, 0xF6, 0xAE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+// Placeholder flash magic value, bit 63 clear because the word holding it is write locked.
+static const uint8_t host_fmv[INFOBLOCK_LINE_SIZE] = { 0x46, 0x4D, 0x56, 0x5F,
+                                                       0x48, 0x4F, 0x53, 0x54 };
+
+static uint8_t host_infoblock[INFOBLOCK_SIZE];
+static uint8_t host_flash[HAL_HOST_FLASH_SIZE];
+static uint8_t host_pubkey[HOST_PUBKEY_SIZE];
+static uint8_t host_mailbox_params[HOST_MAILBOX_PARAMS_SIZE];
+// uint32_t for the alignment mailbox_result_t needs
+static uint32_t host_mailbox_result[HOST_MAILBOX_RESULT_SIZE / sizeof(uint32_t)];
+static uint32_t host_bypass[2];
+static int host_unlocked = 0;
+static hal_uart_tx_callback_t host_uart_tx_callback;
+static int host_uart_tx_enabled;
+static int host_uart_tx_in_irq;
+static int host_uart_tx_latched;
+static unsigned int host_baud = 115200;
+
+static struct {
+    unsigned int unlocks;
+    unsigned int programs;
+    unsigned int rejected;
+    unsigned int uart_bytes;
+} host_stats;
+
+/******************************* Static Functions ****************************/
+static void host_fatal(const char *message)
+{
+    fprintf(stderr, "hal_host: %s\n", message);
+    abort();
+}
+
+static void host_seed_infoblock(void)
+{
+    uint64_t line, usn;
+    int i, j;
+
+    memset(host_infoblock, 0xFF, sizeof(host_infoblock));
+
+    // USN format: lock bit 63 cleared, data in bits [62:15], bits [14:0] ignored
+    for (i = 0; i < HOST_USN_LINES; i++) {
+        usn = 0;
+        for (j = 0; j < INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD; j++) {
+            usn |= (uint64_t)host_usn[i * (INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD) + j]
+                   << (8 * j);
+        }
+        line = (usn << 15) | 0x7FFF;
+        line &= ~((uint64_t)1 << 63);
+        memcpy(&host_infoblock[INFOBLOCK_USN_OFFSET + i * INFOBLOCK_LINE_SIZE], &line,
+               sizeof(line));
+    }
+
+    memcpy(&host_infoblock[INFOBLOCK_FMV_OFFSET], host_fmv, sizeof(host_fmv));
+
+    // The words holding USN and FMV are write locked (bit 127 of each flash word)
+    for (i = 0; i <= INFOBLOCK_FMV_OFFSET; i += INFOBLOCK_FLASH_WORD_SIZE) {
+        host_infoblock[i + INFOBLOCK_FLASH_WORD_SIZE - 1] &= 0x7F;
+    }
+}
+
+// A partial file fills the start of data, otherwise the file must be exactly length bytes
+static void host_load(const char *env, uint8_t *data, size_t length, int partial)
+{
+    const char *path = getenv(env);
+    FILE *f;
+
+    if ((path == NULL) || ((f = fopen(path, "rb")) == NULL)) {
+        return;
+    }
+    if ((fread(data, 1, length, f) != length) && !partial) {
+        fclose(f);
+        host_fatal("short read on image file");
+    }
+    fclose(f);
+}
+
+static void host_save(const char *env, const void *data, size_t length)
+{
+    const char *path = getenv(env);
+    FILE *f;
+
+    if ((path == NULL) || ((f = fopen(path, "wb")) == NULL)) {
+        return;
+    }
+    fwrite(data, 1, length, f);
+    fclose(f);
+}
+
+static void host_exit(void)
+{
+    host_save("HAL_HOST_INFOBLOCK", host_infoblock, sizeof(host_infoblock));
+    host_save("HAL_HOST_RESULT", host_mailbox_result, sizeof(mailbox_result_t));
+
+    if (getenv("HAL_HOST_STATS")) {
+        fprintf(stderr, "hal_host: unlocks=%u programs=%u rejected=%u uart_bytes=%u\n",
+                host_stats.unlocks, host_stats.programs, host_stats.rejected,
+                host_stats.uart_bytes);
+    }
+}
+
+/******************************* Public Functions ****************************/
+int hal_init(void)
+{
+    host_seed_infoblock();
+    memset(host_flash, 0xFF, sizeof(host_flash));
+    memset(host_pubkey, 0xFF, sizeof(host_pubkey));
+
+    host_load("HAL_HOST_INFOBLOCK", host_infoblock, sizeof(host_infoblock), 0);
+    host_load("HAL_HOST_PUBKEY", host_pubkey, sizeof(host_pubkey), 0);
+    host_load("HAL_HOST_MAILBOX", host_mailbox_params, sizeof(host_mailbox_params), 1);
+
+    atexit(host_exit);
+
+    return E_NO_ERROR;
+}
+
+uint32_t hal_cycles(void)
+{
+    struct timespec now;
+
+    // Nanoseconds, a 1 GHz "core"
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + now.tv_nsec);
+}
+
+uint32_t hal_cycles_hz(void)
+{
+    return 1000000000u;
+}
+
+void hal_halt(void)
+{
+    fflush(stdout);
+    exit(0);
+}
+
+int hal_infoblock_unlock(void)
+{
+    host_unlocked = 1;
+    host_stats.unlocks++;
+
+    return E_NO_ERROR;
+}
+
+int hal_infoblock_lock(void)
+{
+    host_unlocked = 0;
+
+    return E_NO_ERROR;
+}
+
+const uint8_t *hal_infoblock_view(uint32_t offset)
+{
+    if (!host_unlocked) {
+        host_fatal("information block read while locked");
+    }
+    if (offset >= INFOBLOCK_SIZE) {
+        host_fatal("information block read out of range");
+    }
+
+    return &host_infoblock[offset];
+}
+
+int hal_infoblock_write128(uint32_t offset, uint32_t *data)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint8_t *word;
+    int i;
+
+    if ((offset % INFOBLOCK_FLASH_WORD_SIZE) ||
+        (offset > INFOBLOCK_SIZE - INFOBLOCK_FLASH_WORD_SIZE)) {
+        return E_BAD_PARAM;
+    }
+    if (!host_unlocked) {
+        host_stats.rejected++;
+        return E_BAD_STATE;
+    }
+
+    word = &host_infoblock[offset];
+    if ((word[INFOBLOCK_FLASH_WORD_SIZE - 1] & 0x80) == 0) {
+        // Write locked word
+        host_stats.rejected++;
+        return E_BAD_STATE;
+    }
+
+    for (i = 0; i < INFOBLOCK_FLASH_WORD_SIZE; i++) {
+        word[i] &= bytes[i];
+    }
+    host_stats.programs++;
+
+    return E_NO_ERROR;
+}
+
+int hal_infoblock_erase_user(void)
+{
+    if (!host_unlocked) {
+        host_stats.rejected++;
+        return E_BAD_STATE;
+    }
+
+    memset(&host_infoblock[INFOBLOCK_USER_SECTION_OFFSET], 0xFF, INFOBLOCK_USER_SECTION_SIZE);
+
+    return E_NO_ERROR;
+}
+
+void hal_flash_read(uint32_t address, uint8_t *data, uint32_t length)
+{
+    if ((address < HAL_FLASH_ADDRESS) ||
+        ((address - HAL_FLASH_ADDRESS) > HAL_HOST_FLASH_SIZE - length)) {
+        host_fatal("flash read out of range");
+    }
+
+    memcpy(data, &host_flash[address - HAL_FLASH_ADDRESS], length);
+}
+
+int hal_flash_mass_erase(void)
+{
+    memset(host_flash, 0xFF, sizeof(host_flash));
+
+    return E_NO_ERROR;
+}
+
+int hal_uart_init(unsigned int baud)
+{
+    host_baud = baud;
+
+    return E_NO_ERROR;
+}
+
+int hal_uart_read_char(void)
+{
+    uint8_t c;
+
+    // Unbuffered so hal_uart_read_char_timeout() can poll the same descriptor
+    fflush(stdout);
+    if (read(STDIN_FILENO, &c, 1) != 1) {
+        // Nobody left to talk to
+        hal_halt();
+    }
+
+    return c;
+}
+
+int hal_uart_read_char_timeout(unsigned int timeout_ms)
+{
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+
+    fflush(stdout);
+    if (poll(&pfd, 1, (int)timeout_ms) <= 0) {
+        return E_TIME_OUT;
+    }
+
+    return hal_uart_read_char();
+}
+
+int hal_uart_get_baud(void)
+{
+    return (int)host_baud;
+}
+
+unsigned int hal_uart_baud_actual(unsigned int baud)
+{
+    // A pty has no clock divisor, every rate is exact
+    return baud;
+}
+
+int hal_uart_set_baud(unsigned int baud)
+{
+    host_baud = baud;
+
+    return (int)host_baud;
+}
+
+void hal_uart_tx_wait_idle(void)
+{
+    fflush(stdout);
+}
+
+int hal_uart_write_char(uint8_t c)
+{
+    host_stats.uart_bytes++;
+    putchar(c);
+
+    return E_NO_ERROR;
+}
+
+int hal_uart_write(const uint8_t *data, int *length)
+{
+    *length = (int)fwrite(data, 1, *length, stdout);
+    host_stats.uart_bytes += *length;
+
+    return E_NO_ERROR;
+}
+
+void hal_uart_clear_rx(void)
+{
+}
+
+int hal_uart_tx_async_init(hal_uart_tx_callback_t callback)
+{
+    host_uart_tx_callback = callback;
+
+    return E_NO_ERROR;
+}
+
+void hal_uart_tx_irq_enable(int enable)
+{
+    // No interrupts here: the FIFO drains at once, so a TX_HE latched by the last FIFO write
+    // fires as soon as the interrupt is enabled, while an idle FIFO never raises it
+    host_uart_tx_enabled = enable;
+    while (host_uart_tx_enabled && host_uart_tx_latched && host_uart_tx_callback &&
+           !host_uart_tx_in_irq) {
+        host_uart_tx_latched = 0;
+        host_uart_tx_in_irq = 1;
+        host_uart_tx_callback();
+        host_uart_tx_in_irq = 0;
+    }
+}
+
+int hal_uart_tx_fifo_write(const uint8_t *data, int length)
+{
+    // Model the 8 byte hardware FIFO so the ring is drained in realistic chunks
+    if (length > HOST_UART_FIFO_SIZE) {
+        length = HOST_UART_FIFO_SIZE;
+    }
+    length = (int)fwrite(data, 1, length, stdout);
+    host_stats.uart_bytes += length;
+    host_uart_tx_latched |= (length > 0);
+
+    return length;
+}
+
+uint32_t hal_mcr_bypass_read(int index)
+{
+    return host_bypass[index & 1];
+}
+
+void hal_mcr_bypass_write(int index, uint32_t value)
+{
+    host_bypass[index & 1] = value;
+}
+
+uint32_t hal_mcr_bypass_address(int index)
+{
+    // MCR BBREG registers on target
+    return 0x50006C30 + 4 * (index & 1);
+}
+
+uint8_t *hal_pubkey(unsigned int *length)
+{
+    *length = sizeof(host_pubkey);
+
+    return host_pubkey;
+}
+
+uint8_t *hal_mailbox_params(unsigned int *length)
+{
+    *length = sizeof(host_mailbox_params);
+
+    return host_mailbox_params;
+}
+
+uint8_t *hal_mailbox_result(unsigned int *length)
+{
+    *length = sizeof(host_mailbox_result);
+
+    return (uint8_t *)host_mailbox_result;
+}
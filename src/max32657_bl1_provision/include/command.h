@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _COMMAND_H_
+#define _COMMAND_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @defgroup    command Line oriented command mode
+ * @brief       Named commands for host automation, as an alternative to the numeric menus
+ * @details     Each input line holds one or more commands separated by ';'. A command is a
+ *              name followed by space separated arguments, usually key=value pairs:
+ *
+ *                  usn; swd.status; dump region=user off=0 len=256
+ *
+ *              Every command ends with one reply line, after any output of its own:
+ *
+ *                  RES <name> status=<error code> us=<elapsed microseconds>
+ *
+ *              Commands after a failing one on the same line are not run, each of them
+ *              replies with status E_ABORT.
+ * @{
+ */
+
+/**
+ * @brief Longest command line accepted, including the terminating NUL
+ */
+#define COMMAND_MAX_LINE 256
+
+/**
+ * @brief Most arguments one command can take, including its name
+ */
+#define COMMAND_MAX_ARGS 8
+
+/**
+ * @brief command_arg    Value of a key=value argument
+ * @param[in]   argc    number of arguments, argv[0] is the command name
+ * @param[in]   argv    arguments
+ * @param[in]   key     key to look for
+ * @return      pointer to the value, NULL if the key is not present
+ */
+const char *command_arg(int argc, char *argv[], const char *key);
+
+/**
+ * @brief command_arg_uint    Numeric value of a key=value argument, decimal or 0x prefixed hex
+ * @param[in]   argc    number of arguments, argv[0] is the command name
+ * @param[in]   argv    arguments
+ * @param[in]   key     key to look for
+ * @param[out]  value   parsed value, or defval when the key is not present
+ * @param[in]   defval  value to use when the key is not present
+ * @return      error_code
+ * @retval      E_NO_ERROR    value is set
+ * @retval      E_BAD_PARAM   the value is not a number
+ */
+int command_arg_uint(int argc, char *argv[], const char *key, uint32_t *value, uint32_t defval);
+
+/**
+ * @brief command_execute_line    Run every command of one line
+ * @param[in,out] line  command line, modified while it is split into arguments
+ * @return      status of the first failing command, E_NO_ERROR if all succeeded
+ */
+int command_execute_line(char *line);
+
+/**
+ * @brief command_loop    Read and run command lines until the exit command
+ * @return      error_code
+ */
+int command_loop(void);
+
+/**@} end of group command */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _COMMAND_H_ */
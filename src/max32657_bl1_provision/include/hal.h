@@ -0,0 +1,284 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#ifdef HAL_HOST
+#include "hal_host.h"
+#else
+#include "mxc_device.h"
+#endif
+
+/**
+ * @defgroup    hal Hardware abstraction layer
+ * @brief       Flash, UART and MCR access used by the provisioning logic
+ * @details     The target backend (hal_msdk.c) maps these calls onto the MSDK drivers.
+ *              The host backend (host/hal_host.c, built with HAL_HOST defined) emulates
+ *              the information block with OTP semantics so the same logic runs on Linux.
+ * @{
+ */
+
+/**
+ * @brief Address of the information block as seen by the CPU, used for printing
+ */
+#define HAL_INFOBLOCK_ADDRESS MXC_INFO_MEM_BASE
+
+/**
+ * @brief Address of the main flash as seen by the CPU
+ */
+#define HAL_FLASH_ADDRESS MXC_FLASH_MEM_BASE
+
+/**
+ * @brief Size of the main flash in bytes
+ */
+#define HAL_FLASH_SIZE MXC_FLASH_MEM_SIZE
+
+/**
+ * @brief hal_init    Initialize the backend, must be called before any other HAL function
+ * @return      error_code
+ * @retval      E_NO_ERROR    backend is ready
+ */
+int hal_init(void);
+
+/**
+ * @brief hal_halt    Stop execution once there is nothing left to do
+ * @note        Spins forever on target, exits the process on host.
+ */
+void hal_halt(void);
+
+/**
+ * @brief hal_cycles    Free running cycle counter, wraps at 32 bits
+ * @return      current count
+ */
+uint32_t hal_cycles(void);
+
+/**
+ * @brief hal_cycles_hz    Rate at which hal_cycles() counts
+ * @return      counts per second
+ */
+uint32_t hal_cycles_hz(void);
+
+/**
+ * @brief hal_infoblock_unlock    Give the CPU access to the information block
+ * @return      error_code
+ * @retval      E_NO_ERROR    information block is accessible
+ */
+int hal_infoblock_unlock(void);
+
+/**
+ * @brief hal_infoblock_lock    Remove CPU access to the information block
+ * @return      error_code
+ * @retval      E_NO_ERROR    information block is locked
+ */
+int hal_infoblock_lock(void);
+
+/**
+ * @brief hal_infoblock_view    Pointer to the information block contents
+ * @note        Only valid while the information block is unlocked.
+ * @param[in]   offset  location in the infoblock, this is a relative offset
+ * @return      pointer to the raw contents at offset
+ */
+const uint8_t *hal_infoblock_view(uint32_t offset);
+
+/**
+ * @brief hal_infoblock_write128    Program one 128-bit flash word of the information block
+ * @param[in]   offset  location in the infoblock, must be 16 byte aligned
+ * @param[in]   data    four words to program
+ * @return      error_code
+ * @retval      E_NO_ERROR    word was programmed
+ */
+int hal_infoblock_write128(uint32_t offset, uint32_t *data);
+
+/**
+ * @brief hal_infoblock_erase_user    Erase the user section of the information block
+ * @return      error_code
+ * @retval      E_NO_ERROR    section was erased
+ */
+int hal_infoblock_erase_user(void);
+
+/**
+ * @brief hal_flash_read    Read from main flash
+ * @param[in]   address absolute address in main flash
+ * @param[out]  data    buffer to fill
+ * @param[in]   length  number of bytes to read
+ */
+void hal_flash_read(uint32_t address, uint8_t *data, uint32_t length);
+
+/**
+ * @brief hal_flash_mass_erase    Erase the whole main flash
+ * @return      error_code
+ * @retval      E_NO_ERROR    flash was erased
+ */
+int hal_flash_mass_erase(void);
+
+/**
+ * @brief hal_uart_init    Configure the console UART
+ * @param[in]   baud    baud rate
+ * @return      error_code
+ * @retval      E_NO_ERROR    UART is configured
+ */
+int hal_uart_init(unsigned int baud);
+
+/**
+ * @brief hal_uart_read_char    Read one character from the console UART
+ * @return      character read, negative error code if none could be read
+ */
+int hal_uart_read_char(void);
+
+/**
+ * @brief hal_uart_write_char    Write one character to the console UART
+ * @param[in]   c   character to write
+ * @return      error_code
+ */
+int hal_uart_write_char(uint8_t c);
+
+/**
+ * @brief hal_uart_write    Write a buffer to the console UART
+ * @param[in]   data    bytes to write
+ * @param[in,out] length  number of bytes to write, updated with the number written
+ * @return      error_code
+ */
+int hal_uart_write(const uint8_t *data, int *length);
+
+/**
+ * @brief hal_uart_clear_rx    Drop any pending received characters
+ */
+void hal_uart_clear_rx(void);
+
+/**
+ * @brief hal_uart_read_char_timeout    Read one character, giving up after a while
+ * @param[in]   timeout_ms  how long to wait for a character
+ * @return      character read
+ * @retval      E_TIME_OUT    nothing was received in time
+ */
+int hal_uart_read_char_timeout(unsigned int timeout_ms);
+
+/**
+ * @brief hal_uart_get_baud    Current console UART baud rate
+ * @return      baud rate, negative error code if it cannot be determined
+ */
+int hal_uart_get_baud(void);
+
+/**
+ * @brief hal_uart_baud_actual    Baud rate the UART clock divisor really produces for a request
+ * @note        Does not touch the UART.
+ * @param[in]   baud    requested baud rate
+ * @return      achievable baud rate closest to the request, 0 if out of range
+ */
+unsigned int hal_uart_baud_actual(unsigned int baud);
+
+/**
+ * @brief hal_uart_set_baud    Change the console UART baud rate
+ * @note        Call hal_uart_tx_wait_idle() first, characters in flight are lost.
+ * @param[in]   baud    requested baud rate
+ * @return      baud rate set, negative error code on failure
+ */
+int hal_uart_set_baud(unsigned int baud);
+
+/**
+ * @brief hal_uart_tx_wait_idle    Wait until the last character has left the TX shift register
+ */
+void hal_uart_tx_wait_idle(void);
+
+/**
+ * @brief Function called from the console UART TX interrupt
+ */
+typedef void (*hal_uart_tx_callback_t)(void);
+
+/**
+ * @brief hal_uart_tx_async_init    Route the console UART TX interrupt to a callback
+ * @note        The interrupt stays disabled until hal_uart_tx_irq_enable() is called.
+ *              It is latched when the TX FIFO level falls to half, so enabling it over an
+ *              idle FIFO does not raise it; fill the FIFO with hal_uart_tx_fifo_write() first.
+ *              On host the callback runs synchronously from hal_uart_tx_irq_enable().
+ * @param[in]   callback    function called whenever the TX FIFO has room
+ * @return      error_code
+ * @retval      E_NO_ERROR    interrupt driven transmit is available
+ */
+int hal_uart_tx_async_init(hal_uart_tx_callback_t callback);
+
+/**
+ * @brief hal_uart_tx_irq_enable    Enable or disable the console UART TX interrupt
+ * @param[in]   enable  non zero to enable
+ */
+void hal_uart_tx_irq_enable(int enable);
+
+/**
+ * @brief hal_uart_tx_fifo_write    Copy as many bytes as fit into the TX FIFO, never blocks
+ * @param[in]   data    bytes to write
+ * @param[in]   length  number of bytes available
+ * @return      number of bytes accepted
+ */
+int hal_uart_tx_fifo_write(const uint8_t *data, int length);
+
+/**
+ * @brief hal_mcr_bypass_read    Read a BBREG bypass register
+ * @param[in]   index   0 for bypass0, 1 for bypass1
+ * @return      register value
+ */
+uint32_t hal_mcr_bypass_read(int index);
+
+/**
+ * @brief hal_mcr_bypass_write    Write a BBREG bypass register
+ * @param[in]   index   0 for bypass0, 1 for bypass1
+ * @param[in]   value   value to write
+ */
+void hal_mcr_bypass_write(int index, uint32_t value);
+
+/**
+ * @brief hal_mcr_bypass_address    Address of a BBREG bypass register, used for printing
+ * @param[in]   index   0 for bypass0, 1 for bypass1
+ * @return      register address
+ */
+uint32_t hal_mcr_bypass_address(int index);
+
+/**
+ * @brief hal_pubkey    Location of the public key to provision
+ * @param[out]  length  key length in bytes
+ * @return      pointer to the key
+ */
+uint8_t *hal_pubkey(unsigned int *length);
+
+/**
+ * @brief hal_mailbox_params    SRAM the host writes the parameter manifest to, see mailbox.h
+ * @param[out]  length  mailbox size in bytes
+ * @return      pointer to the mailbox
+ */
+uint8_t *hal_mailbox_params(unsigned int *length);
+
+/**
+ * @brief hal_mailbox_result    SRAM the host reads the result block from, see mailbox.h
+ * @param[out]  length  result area size in bytes
+ * @return      pointer to the result area
+ */
+uint8_t *hal_mailbox_result(unsigned int *length);
+
+/**@} end of group hal */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HAL_H_ */
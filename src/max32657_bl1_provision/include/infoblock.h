@@ -57,6 +57,26 @@ extern "C" {
  * @brief MAX32655 has 128-bit wide flash so the permanent line lock bit is at the top of every 16 bytes
  */
 #define INFOBLOCK_WRITE_LOCK_LINE_SIZE 16
+/**
+ * @brief Width of one flash program operation, two information block lines are programmed at once
+ */
+#define INFOBLOCK_FLASH_WORD_SIZE 16
+
+/**
+ * @brief Maximum number of lines one infoblock_plan() call can cover
+ */
+#define INFOBLOCK_PLAN_MAX_LINES 32
+
+/**
+ * @brief Maximum number of lines one infoblock_write_verified() call can report on
+ */
+#define INFOBLOCK_VERIFY_MAX_LINES 32
+
+/**
+ * @brief Number of formatted lines infoblock_write() stages before programming them
+ */
+#define INFOBLOCK_WRITE_BATCH_LINES 16
+
 /**
  * @brief Unprogrammed flash reads as all 0xFF
  */
@@ -71,26 +91,40 @@ extern "C" {
 #define ICELOCK_ODD_LOCK_VALUE 0x5A5A
 
 /**
- * @brief Maximum information block read size.  Used in infoblock_read() to
- *  set upper limit on bytes read.
+ * @brief The offset inside the information block where the USN (Universal Serial Number) is stored
  */
-#define INFOBLOCK_MAXIMUM_READ_LENGTH 64
+#define INFOBLOCK_USN_OFFSET 0x00
 
 /**
- * @brief The offset inside the information block where the USN (Universal Serial Number) is stored
+ * @brief Number of USN bytes that identify a part
  */
-#define INFOBLOCK_USN_OFFSET 0x00
+#define INFOBLOCK_USN_LENGTH 13
+
+/**
+ * @brief Size in bytes of the USN region, three USN format lines
+ */
+#define INFOBLOCK_USN_REGION_SIZE 0x18
 
 /**
  * @brief The offset inside the information block where the FMV (Flash Magic Value) is stored
  */
 #define INFOBLOCK_FMV_OFFSET 0x18
 
+/**
+ * @brief Size in bytes of the FMV region
+ */
+#define INFOBLOCK_FMV_REGION_SIZE 0x08
+
 /**
  * @brief The offset inside the information block where the SWD locking information is stored
  * @note There are four locking locations starting at 0x30 for location 0, 0x32 for location 1, 0x34 for location 2, and 0x36 for location 3
  */
 #define INFOBLOCK_ICE_LOCK_OFFSET 0x30
+
+/**
+ * @brief Size in bytes of the ICE lock region, the whole write lock line holding the lock words
+ */
+#define INFOBLOCK_ICE_LOCK_REGION_SIZE 0x10
 /**
  * @brief The minimum number of locations with a lock value to cause SWD to be locked out.
  */
@@ -106,6 +140,11 @@ extern "C" {
  */
 #define INFOBLOCK_KEY_SIZE 64
 
+/**
+ * @brief Size in bytes of the key region, 16 DESIGN format lines hold up to 96 bytes (P-384 key)
+ */
+#define INFOBLOCK_KEY_REGION_SIZE 0x80
+
 /**
  * @brief Storage locations for feature enables.
  *  The value 0x5a5aa5a5_5a5aa5a5 designates enable or disable depending on the function.
@@ -123,6 +162,43 @@ extern "C" {
  */
 #define INFOBLOCK_USER_SECTION_OFFSET 0x3000
 
+/**
+ * @brief Size in bytes of the user parameters section
+ */
+#define INFOBLOCK_USER_SECTION_SIZE (4 * 1024)
+
+/**
+ * @brief Size in bytes of the device section, everything below the key area and the key area itself
+ */
+#define INFOBLOCK_DEVICE_SECTION_SIZE (8 * 1024)
+
+/**
+ * @brief Total size in bytes of the information block
+ */
+#define INFOBLOCK_SIZE (INFOBLOCK_USER_SECTION_OFFSET + INFOBLOCK_USER_SECTION_SIZE)
+
+/**
+ * @brief CRC15 polynomial used by DESIGN format lines (CRC-15/CAN)
+ */
+#define CRC15_POLY 0x4599
+
+/**
+ * @brief CRC15 of the ASCII string "123456789" starting from zero, used as known answer
+ */
+#define CRC15_CHECK_VALUE 0x059E
+
+/**
+ * @brief Size in bytes of the SRAM shadow of the device lines (USN, FMV and ICE lock)
+ * @note Only used when built with INFOBLOCK_SHADOW_CACHE defined.
+ */
+#define INFOBLOCK_SHADOW_DEVICE_SIZE 0x40
+
+/**
+ * @brief Size in bytes of the SRAM shadow of the key lines, large enough for a formatted P-384 key
+ * @note Only used when built with INFOBLOCK_SHADOW_CACHE defined.
+ */
+#define INFOBLOCK_SHADOW_KEY_SIZE INFOBLOCK_KEY_REGION_SIZE
+
 /**
  * @brief Three information block line types
  *
@@ -138,6 +214,18 @@ typedef enum {
     INFOBLOCK_LINE_FORMAT_DESIGN, /**< Design format, has CRC15 in bits 62:48, bit 63 is a line locking bit */
 } lineformat_e;
 
+/**
+ * @brief Description of one region of the information block
+ */
+typedef struct {
+    uint32_t offset; /**< start of the region, line aligned */
+    uint32_t length; /**< length of the region in bytes, whole lines */
+    lineformat_e lineformat; /**< format of every line in the region */
+    uint8_t inverted; /**< TRUE if data is stored bit inverted (erased reads as 0x00) */
+    uint8_t writable; /**< TRUE if infoblock_write() may program the region */
+    uint16_t lockgranularity; /**< bytes covered by one write lock bit, the top bit of the unit */
+} infoblock_region_t;
+
 /**@} end of group infoblock_defines */
 
 /**
@@ -149,6 +237,74 @@ typedef enum {
  */
 uint16_t crc15_highbitinput(uint16_t crc15val, uint8_t *input, int bitlength);
 
+/**
+ * @brief crc15_bytes    Calculate CRC15 on whole bytes using the lookup tables
+ * @param[in]   crc15val    starting CRC15 value
+ * @param[in]   input       pointer to the array of data to CRC15, high bit of each byte first
+ * @param[in]   length      length in bytes of the data to CRC15
+ * @return      crc15val
+ */
+uint16_t crc15_bytes(uint16_t crc15val, const uint8_t *input, int length);
+
+/**
+ * @brief crc15_designline    Calculate CRC15 of a DESIGN format information block line
+ * @note        Covers the lock bit (bit 63) followed by the 48 data bits [47:0],
+ *              the same sequence infoblock_read() and infoblock_write() use.
+ * @param[in]   line    pointer to one information block line (#INFOBLOCK_LINE_SIZE bytes)
+ * @return      crc15val    value expected in bits [62:48]
+ */
+uint16_t crc15_designline(const uint8_t *line);
+
+/**
+ * @brief crc15_selftest    Check the table driven CRC15 against the bit-serial reference
+ * @return      error_code    result of the known answer and equivalence checks
+ * @retval      E_NO_ERROR    all checks passed
+ * @retval      E_BAD_STATE   mismatch detected
+ */
+int crc15_selftest(void);
+
+/**
+ * @brief infoblock_session_open    Open an information block access session
+ * @details     The information block is unlocked at the first access of the outermost session
+ *              and stays accessible until the matching infoblock_session_close(). Sessions nest,
+ *              so routines that open their own session can be called from inside another one
+ *              without extra unlock/lock cycles.
+ * @note        When built with INFOBLOCK_SHADOW_CACHE defined, views of the device and key lines
+ *              are served from an SRAM snapshot and a session that only touches those lines
+ *              never unlocks the information block.
+ * @return      error_code
+ * @retval      E_NO_ERROR    session is open
+ */
+int infoblock_session_open(void);
+
+/**
+ * @brief infoblock_session_close    Close an information block access session
+ * @note        Pointers returned by infoblock_session_view() must not be used after the
+ *              outermost session is closed.
+ * @return      error_code    error if unable to lock the infoblock
+ * @retval      E_NO_ERROR    session is closed
+ * @retval      E_BAD_STATE   no session was open
+ */
+int infoblock_session_close(void);
+
+/**
+ * @brief infoblock_session_view    Get a read-only view of the information block without copying
+ * @param[in]   offset  location in the infoblock, this is a relative offset
+ * @param[in]   length  number of bytes the caller is going to access
+ * @return      pointer to the raw infoblock contents, NULL if no session is open, the range
+ *              does not fit in the information block or the block cannot be unlocked
+ */
+const uint8_t *infoblock_session_view(uint32_t offset, uint32_t length);
+
+/**
+ * @brief infoblock_shadow_invalidate    Drop SRAM shadow lines so they are read from flash again
+ * @note        Lines are invalidated automatically when programmed through this module.
+ *              Does nothing unless built with INFOBLOCK_SHADOW_CACHE defined.
+ * @param[in]   offset  location in the infoblock, this is a relative offset
+ * @param[in]   length  number of bytes to invalidate
+ */
+void infoblock_shadow_invalidate(uint32_t offset, uint32_t length);
+
 /**
  * @brief infoblock_readraw    Read raw data from information block
  * @param[in]   offset  location in the infoblock to read, this is a relative offset
@@ -158,12 +314,19 @@ uint16_t crc15_highbitinput(uint16_t crc15val, uint8_t *input, int bitlength);
  */
 int infoblock_readraw(uint32_t offset, uint8_t *data);
 
+/**
+ * @brief infoblock_region_find    Look up the region holding an offset
+ * @param[in]   offset  location in the infoblock, this is a relative offset
+ * @return      region description, NULL if the offset is not inside a known region
+ */
+const infoblock_region_t *infoblock_region_find(uint32_t offset);
+
 /**
  * @brief infoblock_read    Read formatted data from information block
- * @note        This routine uses the offest to determine the format of the data,
- *              and will read the correct number of raw bytes be able to return
+ * @note        This routine uses the region holding offset to determine the format of
+ *              the data, and will read the correct number of raw bytes be able to return
  *              the number of data bytes specified. The CRC15 and formatting will
- *              be removed and the data returned.
+ *              be removed and the data returned. The read must stay inside the region.
  * @param[in]   offset  location in the infoblock to read, this is a relative offset
  * @param[out]  data    pointer to array where data will be stored.
  * @param[in]   length  number of bytes to read
@@ -212,20 +375,76 @@ int infoblock_checkpermicelock(void);
  */
 int infoblock_writeraw(uint32_t offset, uint32_t *data);
 
+/**
+ * @brief infoblock_plan    Work out which lines must be programmed to reach an image
+ * @details     Lines that already hold their target are skipped. A line that needs a bit
+ *              to go from 0 to 1, or that must change while write locked, cannot be reached.
+ * @param[in]   offset          location in the infoblock of the first line, must be line aligned
+ * @param[in]   image           desired contents, numlines * #INFOBLOCK_LINE_SIZE bytes
+ * @param[in]   numlines        number of lines, at most #INFOBLOCK_PLAN_MAX_LINES
+ * @param[out]  programlines    bit n is set if line n must be programmed
+ * @return      error_code    error if unable to access infoblock
+ * @retval      E_NO_ERROR    every line can be reached, programlines holds the plan
+ * @retval      E_BAD_PARAM   if the lines do not fit in the information block
+ * @retval      E_BAD_STATE   if a line cannot be reached by programming
+ */
+int infoblock_plan(uint32_t offset, const uint8_t *image, int numlines, uint32_t *programlines);
+
+/**
+ * @brief infoblock_writerawlines    Write several raw lines to information block
+ * @details     All lines are programmed inside one unlock window. The lines are planned with
+ *              infoblock_plan() first, nothing is programmed if any of them cannot be reached
+ *              and lines that already hold their value are skipped. Pairs of adjacent lines
+ *              that share a 128-bit flash word are programmed with a single flash write.
+ * @param[in]   offset      location in the infoblock to write, must be line aligned
+ * @param[in]   data        pointer to array of numlines * #INFOBLOCK_LINE_SIZE bytes to be stored.
+ * @param[in]   numlines    number of lines to write
+ * @return      error_code    error if unable to access infoblock
+ * @retval      E_NO_ERROR    write was successful
+ * @retval      E_BAD_PARAM   if the lines do not fit in the information block
+ * @retval      E_BAD_STATE   if a line cannot be reached by programming
+ */
+int infoblock_writerawlines(uint32_t offset, uint32_t *data, int numlines);
+
 /**
  * @brief infoblock_write    Write formatted data to the information block
- * @note        This routine uses the offest to determine the format of the data,
+ * @note        This routine uses the region holding offset to determine the format of the data,
  *              and will add formatting and CRC15 as needed
  *              and write the resulting data to the information block.
+ *              The payload must fit in a writable region and every formatted line must be
+ *              reachable by programming, otherwise nothing is programmed. Lines that already
+ *              hold their value are not programmed again.
+ *              Lines are staged in batches of #INFOBLOCK_WRITE_BATCH_LINES and
+ *              programmed with infoblock_writerawlines().
  * @param[in]   offset  location in the infoblock to write, this is a relative offset
  * @param[in]   data    pointer to array of data to be stored.
  * @param[in]   length  number of bytes of data to write
  * @return      error_code    error if unable to access infoblock
  * @retval      E_NO_ERROR    write was successful
  * @retval      E_BAD_PARAM   if incorrect length or offset is supplied
+ * @retval      E_BAD_STATE   if a line needs a 0 to 1 transition or must change while write locked
  */
 int infoblock_write(uint32_t offset, uint8_t *data, int length);
 
+/**
+ * @brief infoblock_write_verified    Write formatted data and read every line back
+ * @note        Same as infoblock_write(), but each programmed batch is re-read and compared
+ *              line by line with the formatted data, including the CRC15 of DESIGN lines.
+ *              Programming stops at the first batch that does not match.
+ * @param[in]   offset      location in the infoblock to write, this is a relative offset
+ * @param[in]   data        pointer to array of data to be stored.
+ * @param[in]   length      number of bytes of data to write
+ * @param[out]  failedlines bit n is set if line n of the write did not read back correctly,
+ *                          0 when nothing was programmed
+ * @return      error_code    error if unable to access infoblock
+ * @retval      E_NO_ERROR    write was successful and every line verified
+ * @retval      E_NULL_PTR    if failedlines is NULL
+ * @retval      E_BAD_PARAM   if incorrect length or offset is supplied, or the write
+ *                            needs more than #INFOBLOCK_VERIFY_MAX_LINES lines
+ * @retval      E_BAD_STATE   if a line cannot be reached by programming or failed to verify
+ */
+int infoblock_write_verified(uint32_t offset, uint8_t *data, int length, uint32_t *failedlines);
+
 /**
  * @brief      Unlock info block
  *
@@ -0,0 +1,177 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _MAILBOX_H_
+#define _MAILBOX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @defgroup    mailbox SRAM parameter and result mailbox
+ * @brief       Provisioning parameters written by the host over SWD, and the result read back
+ * @details     The linker script keeps the last 4KB of SRAM (0x3003F000) out of the image.
+ *              After loading the unmodified ELF, the host writes a parameter manifest there
+ *              with J-Link's loadbin, so one image serves every key and lock policy:
+ *
+ *                  magic (le32) version (le16) length (le16) CRC32 (le32) TLVs[length]
+ *
+ *              CRC32 is zlib's, over the TLV bytes. Each TLV is tag (le16), length (le16)
+ *              and value. Unknown tags are skipped so newer hosts can add parameters.
+ *              Without a manifest the key comes from the .pubkey section of the ELF.
+ *
+ *              The second half (0x3003F800) holds mailbox_result_t, filled in as provisioning
+ *              goes. The host polls it over SWD until phase reads MAILBOX_PHASE_DONE, which is
+ *              written last. The host clears the magic before starting the firmware so a result
+ *              left in SRAM by an earlier run is never taken for this one.
+ * @{
+ */
+
+/**
+ * @brief Address of the parameter manifest, must match the linker script and the host
+ */
+#define MAILBOX_PARAMS_ADDRESS 0x3003F000
+
+#define MAILBOX_PARAMS_MAGIC 0x50314C42 // "BL1P"
+#define MAILBOX_PARAMS_VERSION 1
+#define MAILBOX_PARAMS_HEADER_SIZE 12
+
+#define MAILBOX_TAG_CRK 0x0001 // 64 byte public key, X || Y
+#define MAILBOX_TAG_LOCK_POLICY 0x0002 // one byte, MAILBOX_LOCK_*
+#define MAILBOX_TAG_FLAGS 0x0003 // le32, MAILBOX_FLAG_*
+
+#define MAILBOX_LOCK_NONE 0 // write the CRK only
+#define MAILBOX_LOCK_DEBUG 1 // then lock the debug port
+#define MAILBOX_LOCK_PERMANENT 2 // then freeze the debug port state, the default
+
+#define MAILBOX_FLAG_COMMAND_MODE (1 << 0) // run the command loop instead of provisioning
+#define MAILBOX_FLAG_TEST_MENU (1 << 1) // enter the test menu when done instead of halting
+
+#define MAILBOX_CRK_SIZE 64
+
+/**
+ * @brief Address of the result block, must match the linker script and the host
+ */
+#define MAILBOX_RESULT_ADDRESS 0x3003F800
+
+#define MAILBOX_RESULT_MAGIC 0x52314C42 // "BL1R"
+#define MAILBOX_RESULT_VERSION 1
+
+// Provisioning phases, step_status[phase - 1] and step_cycles[phase - 1] belong to each step
+#define MAILBOX_PHASE_BOOT 0 // result block initialized, no step started yet
+#define MAILBOX_PHASE_USN 1 // read the USN
+#define MAILBOX_PHASE_PARAMS 2 // validate the parameter manifest
+#define MAILBOX_PHASE_CRK 3 // write and verify the CRK
+#define MAILBOX_PHASE_SWD_LOCK 4 // lock the debug port
+#define MAILBOX_PHASE_SWD_PERMANENT 5 // freeze the debug port state
+#define MAILBOX_PHASE_CONSOLE 6 // drain the console output
+#define MAILBOX_PHASE_DONE 0xFF // every field is final
+
+#define MAILBOX_RESULT_STEPS 8 // room for phases added later, the layout stays the same
+#define MAILBOX_STATUS_NOT_RUN 1 // step status until the step ends, error codes are <= 0
+
+/**
+ * @brief    Result block, every field little endian and 32 bit aligned for SWD reads
+ */
+typedef struct {
+    uint32_t magic; /**< MAILBOX_RESULT_MAGIC */
+    uint32_t version; /**< MAILBOX_RESULT_VERSION */
+    uint32_t phase; /**< MAILBOX_PHASE_* being run, MAILBOX_PHASE_DONE when finished */
+    int32_t status; /**< overall error_code, valid once phase is MAILBOX_PHASE_DONE */
+    int32_t step_status[MAILBOX_RESULT_STEPS]; /**< error_code or MAILBOX_STATUS_NOT_RUN */
+    uint32_t step_cycles[MAILBOX_RESULT_STEPS]; /**< hal_cycles() taken by each step */
+    uint32_t cycles_hz; /**< hal_cycles_hz() */
+    uint32_t debug_locks; /**< final debug_status_t */
+    uint32_t debug_unlocks;
+    uint32_t debug_locked;
+    uint32_t debug_permanent;
+    uint8_t usn[16]; /**< INFOBLOCK_USN_LENGTH bytes, zero padded */
+    uint8_t crk_sha256[32]; /**< SHA-256 of the CRK read back from the information block */
+} mailbox_result_t;
+
+/**
+ * @brief mailbox_params_load    Validate the manifest and take a copy of its parameters
+ * @details     The magic is cleared afterwards, so a reset without a new manifest does not
+ *              run again with stale parameters.
+ * @return      error_code
+ * @retval      E_NO_ERROR      manifest accepted
+ * @retval      E_NONE_AVAIL    no manifest, the defaults and the ELF key are used
+ * @retval      E_INVALID       corrupted or unsupported manifest, nothing must be provisioned
+ */
+int mailbox_params_load(void);
+
+/**
+ * @brief mailbox_params_status    Result of the last mailbox_params_load()
+ * @return      error_code, see mailbox_params_load()
+ */
+int mailbox_params_status(void);
+
+/**
+ * @brief mailbox_key    Public key to provision
+ * @param[out]  length  key length in bytes
+ * @return      the manifest key, else the .pubkey section key, NULL after a bad manifest
+ */
+uint8_t *mailbox_key(unsigned int *length);
+
+/**
+ * @brief mailbox_lock_policy    What secure_boot_enable() does after writing the CRK
+ * @return      MAILBOX_LOCK_*
+ */
+unsigned int mailbox_lock_policy(void);
+
+/**
+ * @brief mailbox_flags    Run time options
+ * @return      MAILBOX_FLAG_* bits
+ */
+uint32_t mailbox_flags(void);
+
+/**
+ * @brief mailbox_result_init    Start a new result block, every step MAILBOX_STATUS_NOT_RUN
+ */
+void mailbox_result_init(void);
+
+/**
+ * @brief mailbox_result_begin    Record that a step started
+ * @param[in]   phase   MAILBOX_PHASE_* of the step
+ */
+void mailbox_result_begin(unsigned int phase);
+
+/**
+ * @brief mailbox_result_end    Record the status and duration of a step
+ * @param[in]   phase   MAILBOX_PHASE_* given to mailbox_result_begin()
+ * @param[in]   status  error_code of the step
+ */
+void mailbox_result_end(unsigned int phase, int status);
+
+/**
+ * @brief mailbox_result_finish    Fill in the device state and mark the result final
+ * @details     Reads the USN, the CRK and the debug port state back from the information block.
+ * @param[in]   status  overall error_code
+ */
+void mailbox_result_finish(int status);
+
+/**@} end of group mailbox */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MAILBOX_H_ */
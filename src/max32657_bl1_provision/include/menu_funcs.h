@@ -34,6 +34,15 @@ int swd_status(const char *parentName);
 
 int crk_write(const char *parentName);
 int crk_dump(const char *parentName);
+int crc15_check(const char *parentName);
+int terminal_stats(const char *parentName);
+int terminal_toggle_binary(const char *parentName);
+int terminal_toggle_compress(const char *parentName);
+int negotiate_baud(const char *parentName);
+int command_mode(const char *parentName);
+#ifdef BL1_PROBES
+int timing_probes(const char *parentName);
+#endif
 
 int secure_boot_toggle_mode(const char *parentName);
 int secure_boot_is_enable(const char *parentName);
@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _PROBE_H_
+#define _PROBE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "hal.h"
+
+/**
+ * @defgroup    probe Cycle counter probes
+ * @brief       Count, min, max and total hal_cycles() of the flash, OTP and console hot paths
+ * @details     Built with BL1_PROBES only. Without it the macros below expand to nothing and
+ *              probe.c is empty, so the default image is unchanged. The table lives in SRAM
+ *              and is printed by the "Timing Probes" test menu entry or the probes command.
+ * @{
+ */
+
+/**
+ * @brief    Probed code paths
+ */
+typedef enum {
+    PROBE_INFOBLOCK_READ, /**< infoblock_read(), session open to close */
+    PROBE_INFOBLOCK_WRITE, /**< infoblock_write() and infoblock_write_verified() */
+    PROBE_INFOBLOCK_CRC, /**< crc15_designline(), one line */
+    PROBE_FLC_WRITE, /**< hal_infoblock_write128(), one 128-bit flash word */
+    PROBE_TERMINAL_WRITE, /**< handing one terminal_printf() to the UART or the TX ring */
+    PROBE_TERMINAL_FLUSH, /**< terminal_flush(), waiting for the TX ring to drain */
+    // Result block steps, in MAILBOX_PHASE_* order starting at MAILBOX_PHASE_USN
+    PROBE_STEP_USN,
+    PROBE_STEP_PARAMS,
+    PROBE_STEP_CRK,
+    PROBE_STEP_SWD_LOCK,
+    PROBE_STEP_SWD_PERMANENT,
+    PROBE_STEP_CONSOLE,
+    PROBE_COUNT
+} probe_id_t;
+
+#ifdef BL1_PROBES
+
+/**
+ * @brief   Open a probe in the current scope, close it with PROBE_END() in the same scope
+ */
+#define PROBE_BEGIN(id) uint32_t probe_start_##id = hal_cycles()
+#define PROBE_END(id) probe_record(id, hal_cycles() - probe_start_##id)
+#define PROBE_RECORD(id, cycles) probe_record(id, cycles)
+
+/**
+ * @brief probe_record    Add one measurement to a probe
+ * @param[in]   id      probe_id_t
+ * @param[in]   cycles  hal_cycles() taken
+ */
+void probe_record(unsigned int id, uint32_t cycles);
+
+/**
+ * @brief probe_reset    Clear every probe
+ */
+void probe_reset(void);
+
+/**
+ * @brief probe_report    Print every probe that has measurements on the console
+ * @return  E_NO_ERROR
+ */
+int probe_report(void);
+
+#else
+
+#define PROBE_BEGIN(id)
+#define PROBE_END(id)
+#define PROBE_RECORD(id, cycles)
+
+#endif
+
+/**@} end of group probe */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROBE_H_ */
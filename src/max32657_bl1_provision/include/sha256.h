@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#ifndef _SHA256_H_
+#define _SHA256_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @defgroup    sha256 SHA-256
+ * @brief       Small software SHA-256 (FIPS 180-4), for fingerprints reported to the host
+ * @{
+ */
+
+#define SHA256_DIGEST_SIZE 32
+
+/**
+ * @brief    Running hash state, see sha256_init()
+ */
+typedef struct {
+    uint32_t state[8];
+    uint64_t length; /**< bytes hashed so far */
+    uint8_t block[64];
+} sha256_ctx_t;
+
+/**
+ * @brief sha256_init    Start a new hash
+ * @param[out]  ctx     hash state
+ */
+void sha256_init(sha256_ctx_t *ctx);
+
+/**
+ * @brief sha256_update    Hash more data
+ * @param[in,out] ctx   hash state
+ * @param[in]   data    data to hash
+ * @param[in]   len     number of bytes
+ */
+void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, unsigned int len);
+
+/**
+ * @brief sha256_final    Finish the hash
+ * @param[in,out] ctx   hash state, must be initialized again before reuse
+ * @param[out]  digest  SHA256_DIGEST_SIZE bytes
+ */
+void sha256_final(sha256_ctx_t *ctx, uint8_t *digest);
+
+/**
+ * @brief sha256    Hash one buffer
+ * @param[in]   data    data to hash
+ * @param[in]   len     number of bytes
+ * @param[out]  digest  SHA256_DIGEST_SIZE bytes
+ */
+void sha256(const uint8_t *data, unsigned int len, uint8_t *digest);
+
+/**@} end of group sha256 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SHA256_H_ */
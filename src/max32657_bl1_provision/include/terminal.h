@@ -20,23 +20,149 @@
 #define _TERMINAL_H_
 
 /*******************************      INCLUDES    ****************************/
+#include <stddef.h>
+#include <stdint.h>
 
 /*******************************      DEFINES     ****************************/
 #define KEY_ESC -0x1B
 #define KEY_CANCEL -0x1B
 #define KEY_ENTER -0x0A
 
+// terminal_dump() flags
+#define TERMINAL_DUMP_ADDRESS (1 << 0) // rows as "\n\r0x<address>: xx xx ..", otherwise "\r\nXX XX .."
+#define TERMINAL_DUMP_INVERT (1 << 1) // XOR every byte with 0xFF before printing
+#define TERMINAL_DUMP_ASCII (1 << 2) // append a |printable characters| gutter to each row
+
+#define TERMINAL_DUMP_MAX_WIDTH 32
+
+/*
+ * Binary frames: 0x00, COBS(type, sequence, payload, CRC32 little endian), 0x00.
+ * The CRC32 is zlib's, over type, sequence and payload.
+ */
+#define TERMINAL_FRAME_MAX_PAYLOAD 256
+#define TERMINAL_FRAME_BEGIN 0x01 // payload: address (le32), length (le32), block name
+#define TERMINAL_FRAME_DATA 0x02 // payload: address (le32), data
+#define TERMINAL_FRAME_END 0x03 // payload: CRC32 (le32) of all the block data
+#define TERMINAL_FRAME_FILL 0x04 // payload: address (le32), length (le32), byte repeated length times
+#define TERMINAL_FRAME_LOG 0x05 // payload: format ID (le32), arguments, see TERMINAL_LOG()
+
+// Most arguments a TERMINAL_LOG() message can take
+#define TERMINAL_LOG_MAX_ARGS 8
+
+#ifdef TERMINAL_DEFERRED_LOG
+/*
+ * Deferred logging: the format string is placed in the .tlog_fmt section, which the linker
+ * script keeps in the ELF but never loads, and its offset there is the format ID. Only the
+ * ID and the raw arguments are sent, as a TERMINAL_FRAME_LOG frame: integers as le32 and
+ * strings as their characters and a NUL. decode_frames.py --elf <elf> rebuilds the text.
+ */
+#define TERMINAL_LOG(format, ...)                                                              \
+    do {                                                                                       \
+        static const char terminal_log_format[] __attribute__((section(".tlog_fmt"), used)) = \
+            format;                                                                            \
+        /* A closing empty entry keeps the array valid without arguments */                  \
+        const terminal_log_arg_t terminal_log_args[] = { TERMINAL_LOG_ARGS(__VA_ARGS__)       \
+                                                             { NULL, 0 } };                    \
+        terminal_log_send(terminal_log_format, terminal_log_args,                              \
+                          sizeof(terminal_log_args) / sizeof(terminal_log_args[0]) - 1);       \
+    } while (0)
+#else
+#define TERMINAL_LOG(format, ...) terminal_printf(format, ##__VA_ARGS__)
+#endif
+
+// Argument count, 0 to TERMINAL_LOG_MAX_ARGS
+#define TERMINAL_LOG_NARGS(...) TERMINAL_LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TERMINAL_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define TERMINAL_LOG_CAT(a, b) TERMINAL_LOG_CAT_(a, b)
+#define TERMINAL_LOG_CAT_(a, b) a##b
+
+// One terminal_log_arg_t initializer per argument, each followed by a comma
+#define TERMINAL_LOG_ARGS(...) \
+    TERMINAL_LOG_CAT(TERMINAL_LOG_ARGS_, TERMINAL_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define TERMINAL_LOG_ARGS_0()
+#define TERMINAL_LOG_ARGS_1(a) TERMINAL_LOG_ARG(a),
+#define TERMINAL_LOG_ARGS_2(a, ...) TERMINAL_LOG_ARG(a), TERMINAL_LOG_ARGS_1(__VA_ARGS__)
+#define TERMINAL_LOG_ARGS_3(a, ...) TERMINAL_LOG_ARG(a), TERMINAL_LOG_ARGS_2(__VA_ARGS__)
+#define TERMINAL_LOG_ARGS_4(a, ...) TERMINAL_LOG_ARG(a), TERMINAL_LOG_ARGS_3(__VA_ARGS__)
+#define TERMINAL_LOG_ARGS_5(a, ...) TERMINAL_LOG_ARG(a), TERMINAL_LOG_ARGS_4(__VA_ARGS__)
+#define TERMINAL_LOG_ARGS_6(a, ...) TERMINAL_LOG_ARG(a), TERMINAL_LOG_ARGS_5(__VA_ARGS__)
+#define TERMINAL_LOG_ARGS_7(a, ...) TERMINAL_LOG_ARG(a), TERMINAL_LOG_ARGS_6(__VA_ARGS__)
+#define TERMINAL_LOG_ARGS_8(a, ...) TERMINAL_LOG_ARG(a), TERMINAL_LOG_ARGS_7(__VA_ARGS__)
+
+// Strings are sent by value, everything else as a 32 bit integer
+#define TERMINAL_LOG_ARG(x)                                                                \
+    _Generic((x), char *: terminal_log_arg_string, const char *: terminal_log_arg_string, \
+             default: terminal_log_arg_int)(x)
+
 /******************************* Type Definitions ****************************/
 typedef struct {
     const char *name;
     int (*callback)(const char *parentName);
 } list_t;
 
+typedef struct {
+    unsigned int size; // TX ring size in bytes, 0 when output is written synchronously
+    unsigned int highwater; // most bytes ever queued at once
+    unsigned int overflows; // writes that had to wait for room in the ring
+} terminal_tx_stats_t;
+
+typedef struct {
+    const char *string; // NULL for an integer argument
+    uint32_t value;
+} terminal_log_arg_t;
+
+static inline terminal_log_arg_t terminal_log_arg_string(const char *string)
+{
+    return (terminal_log_arg_t){ string, 0 };
+}
+
+static inline terminal_log_arg_t terminal_log_arg_int(uint32_t value)
+{
+    return (terminal_log_arg_t){ NULL, value };
+}
+
 /******************************* Public Functions ****************************/
 int terminal_init(void);
 int terminal_printf(const char *format, ...);
+// Backend of TERMINAL_LOG() in TERMINAL_DEFERRED_LOG builds
+int terminal_log_send(const char *format, const terminal_log_arg_t *args, unsigned int count);
+int terminal_flush(void);
+void terminal_tx_stats(terminal_tx_stats_t *stats);
+void terminal_dump(uint32_t address, const uint8_t *data, unsigned int len, unsigned int width,
+                   unsigned int flags);
 void terminal_hexdump(const char *title, char *buf, unsigned int len);
+
+/*
+ * Baud rate handshake, all messages at the current rate unless noted:
+ *   target: "BAUD-OFFER <rate> <rate> ..."     host: "<rate>\r"
+ *   target: "BAUD-OK <rate>", both sides switch to <rate>
+ *   host: 55 AA 00 FF 0F F0 33 CC              target: echoes the same 8 bytes
+ *   host: "\r" to confirm
+ * On any error or timeout the target goes back to the old rate and sends "BAUD-FAIL",
+ * including a host that does not answer the offer within a few seconds.
+ */
+int terminal_negotiate_baud(void);
+
+// CRC32 as computed by zlib's crc32(), pass 0 to start and the previous result to continue
+uint32_t terminal_crc32(uint32_t crc, const uint8_t *data, unsigned int len);
+void terminal_set_binary(int enable);
+int terminal_get_binary(void);
+/*
+ * Compressed block dumps: binary mode sends runs of one byte value as fill frames, text mode
+ * replaces rows repeating the row above with "0x<first>-0x<last>: *"
+ */
+void terminal_set_compress(int enable);
+int terminal_get_compress(void);
+int terminal_frame_send(uint8_t type, const uint8_t *header, unsigned int headerlen,
+                        const uint8_t *data, unsigned int len, uint8_t mask);
+// Dump a block of memory, as binary frames in binary mode and as an address prefixed hex dump otherwise
+void terminal_block_begin(const char *name, uint32_t address, uint32_t length);
+void terminal_block_data(uint32_t address, const uint8_t *data, unsigned int len,
+                         unsigned int flags);
+void terminal_block_end(void);
 int terminal_read_num(unsigned int timeout);
+// Read one line without echo, returns its length, the line is always NUL terminated
+int terminal_read_line(char *line, int size);
 int terminal_select_from_list(const char *title, const list_t *items, int nb_items, int nb_col);
 
 #endif // _TERMINAL_H_
@@ -28,3 +28,17 @@
 
 MSECURITY_MODE=SECURE
 LINKERFILE=max32657_ram.ld
+
+# Serve information block status queries from an SRAM snapshot of the lines they use
+PROJ_CFLAGS += -DINFOBLOCK_SHADOW_CACHE
+
+# Queue console output in a ring drained by the UART TX interrupt instead of busy waiting
+PROJ_CFLAGS += -DTERMINAL_ASYNC_TX
+
+# Send TERMINAL_LOG() messages as format IDs and raw arguments, decode them with
+# decode_frames.py --elf bl1_provision.elf
+# PROJ_CFLAGS += -DTERMINAL_DEFERRED_LOG
+
+# Count cycles spent in OTP reads, writes and CRCs, flash writes, console output and each
+# provisioning step, print them with the "Timing Probes" test menu entry or the probes command
+# PROJ_CFLAGS += -DBL1_PROBES
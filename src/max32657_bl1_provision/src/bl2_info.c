@@ -21,10 +21,7 @@
 #include <stdint.h>
 #include <string.h>
 
-#include "mxc_device.h"
-#include "mcr_regs.h" // For BBREG0 register.
-#include "flc.h"
-
+#include "hal.h"
 #include "menu_funcs.h"
 #include "terminal.h"
 #include "infoblock.h"
@@ -71,21 +68,9 @@ max32657_otp_nv_counters_region_t;
 //******************************************************************************
 static int get_bl2_provision_info(max32657_otp_nv_counters_region_t *counters)
 {
-    int addr = MXC_INFO_MEM_BASE + 0x3000;
-    unsigned int len = sizeof(max32657_otp_nv_counters_region_t);
-    unsigned char *ptr = (unsigned char *)counters;
-
-    MXC_FLC_UnlockInfoBlock(MXC_INFO_MEM_BASE);
-    memcpy(ptr, (uint8_t *)addr, len);
-    MXC_FLC_LockInfoBlock(MXC_INFO_MEM_BASE);
-
-    // XOR with 0xff
-    for (unsigned int i = 0; i < len; i++) {
-        *ptr = *ptr ^ 0xff;
-        ptr++;
-    }
-
-    return 0;
+    // The user section is stored inverted, infoblock_read() undoes the inversion
+    return infoblock_read(INFOBLOCK_USER_SECTION_OFFSET, (uint8_t *)counters,
+                          sizeof(max32657_otp_nv_counters_region_t));
 }
 
 int dump_bl2_params(const char *parentName)
@@ -94,6 +79,16 @@ int dump_bl2_params(const char *parentName)
 
     get_bl2_provision_info(&bl2_info);
 
+    if (terminal_get_binary()) {
+        // One block holding the decoded structure, the host tool knows its layout
+        terminal_block_begin("bl2_params", HAL_INFOBLOCK_ADDRESS + INFOBLOCK_USER_SECTION_OFFSET,
+                             sizeof(bl2_info));
+        terminal_block_data(HAL_INFOBLOCK_ADDRESS + INFOBLOCK_USER_SECTION_OFFSET,
+                            (const uint8_t *)&bl2_info, sizeof(bl2_info), 0);
+        terminal_block_end();
+        return 0;
+    }
+
     terminal_hexdump("\n\rHUK", (char *)bl2_info.huk, sizeof(bl2_info.huk));
     terminal_hexdump("\n\rIAK", (char *)bl2_info.iak, sizeof(bl2_info.iak));
     terminal_printf("\n\rIAK Len : 0x%08X\n\r", bl2_info.iak_len);
@@ -0,0 +1,389 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************      INCLUDES    ****************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal.h"
+#include "command.h"
+#include "terminal.h"
+#include "menu_funcs.h"
+#include "infoblock.h"
+#include "swd_lock.h"
+
+/*******************************      DEFINES     ****************************/
+// Bytes read from main flash at a time by the dump command
+#define COMMAND_FLASH_CHUNK 256
+
+/******************************* Type Definitions ****************************/
+typedef struct {
+    const char *name;
+    const char *help;
+    // Either a command taking arguments, or a menu function run as is
+    int (*handler)(int argc, char *argv[]);
+    int (*menu)(const char *parentName);
+} command_t;
+
+typedef struct {
+    const char *name;
+    uint32_t offset; // in the information block, or in main flash for the flash region
+    uint32_t length;
+    unsigned int flags; // terminal_dump() flags
+    unsigned int flash;
+} command_region_t;
+
+/******************************* Static Functions ****************************/
+static int command_help(int argc, char *argv[]);
+static int command_exit(int argc, char *argv[]);
+static int command_usn(int argc, char *argv[]);
+static int command_swd_status(int argc, char *argv[]);
+static int command_swd_lock(int argc, char *argv[]);
+static int command_swd_unlock(int argc, char *argv[]);
+static int command_swd_permanent(int argc, char *argv[]);
+static int command_secureboot_status(int argc, char *argv[]);
+static int command_dump(int argc, char *argv[]);
+static int command_binary(int argc, char *argv[]);
+static int command_compress(int argc, char *argv[]);
+
+/*******************************    Variables   ****************************/
+static const command_t command_table[] = {
+    { "help", "list commands", command_help, NULL },
+    { "exit", "leave command mode", command_exit, NULL },
+    { "usn", "print the USN", command_usn, NULL },
+    { "crk.write", "program the CRK and verify it", NULL, crk_write },
+    { "crk.dump", "print the programmed CRK", NULL, crk_dump },
+    { "swd.status", "debug port lock state", command_swd_status, NULL },
+    { "swd.lock", "lock the debug port", command_swd_lock, NULL },
+    { "swd.unlock", "unlock the debug port", command_swd_unlock, NULL },
+    { "swd.permanent", "freeze the debug port state", command_swd_permanent, NULL },
+    { "secureboot.status", "fails unless secure boot is enabled", command_secureboot_status,
+      NULL },
+    { "secureboot.enable", "write CRK, lock and freeze the debug port", NULL,
+      secure_boot_enable },
+    { "warmboot.toggle", "toggle the warm boot magic value", NULL, secure_boot_toggle_mode },
+    { "dump", "region=device|user|key|flash [off=<n>] [len=<n>]", command_dump, NULL },
+    { "binary", "on|off, dump as binary frames", command_binary, NULL },
+    { "compress", "on|off, collapse repeated dump data", command_compress, NULL },
+    { "crc15.test", "CRC15 self test", NULL, crc15_check },
+    { "tx.stats", "console TX ring statistics", NULL, terminal_stats },
+#ifdef BL1_PROBES
+    { "probes", "cycle counter probe table", NULL, timing_probes },
+#endif
+};
+
+static const command_region_t command_regions[] = {
+    { "device", 0, INFOBLOCK_DEVICE_SECTION_SIZE, 0, 0 },
+    { "user", INFOBLOCK_USER_SECTION_OFFSET, INFOBLOCK_USER_SECTION_SIZE, TERMINAL_DUMP_INVERT, 0 },
+    { "key", INFOBLOCK_KEY_OFFSET, INFOBLOCK_KEY_REGION_SIZE, 0, 0 },
+    { "flash", 0, HAL_FLASH_SIZE, 0, 1 },
+};
+
+static unsigned int command_done;
+
+static int command_help(int argc, char *argv[])
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(command_table) / sizeof(command_table[0]); i++) {
+        terminal_printf("%-18s %s\r\n", command_table[i].name, command_table[i].help);
+    }
+
+    return E_NO_ERROR;
+}
+
+static int command_exit(int argc, char *argv[])
+{
+    command_done = 1;
+
+    return E_NO_ERROR;
+}
+
+static int command_usn(int argc, char *argv[])
+{
+    uint8_t usn[INFOBLOCK_USN_LENGTH];
+    int ret;
+
+    if ((ret = infoblock_read(INFOBLOCK_USN_OFFSET, usn, sizeof(usn))) == E_NO_ERROR) {
+        terminal_hexdump("USN:", (char *)usn, sizeof(usn));
+    }
+
+    return ret;
+}
+
+static int command_swd_status(int argc, char *argv[])
+{
+    debug_status_t st;
+
+    debug_status(&st);
+    terminal_printf("locked=%u permanent=%u locks=%u unlocks=%u\r\n", st.locked, st.permanent,
+                    st.locks, st.unlocks);
+
+    return E_NO_ERROR;
+}
+
+// The menu functions report through text, judge them by the resulting lock state
+static int command_swd_lock(int argc, char *argv[])
+{
+    swd_lock(NULL);
+
+    return debug_status(NULL) ? E_NO_ERROR : E_BAD_STATE;
+}
+
+static int command_swd_unlock(int argc, char *argv[])
+{
+    swd_unlock(NULL);
+
+    return debug_status(NULL) ? E_BAD_STATE : E_NO_ERROR;
+}
+
+static int command_swd_permanent(int argc, char *argv[])
+{
+    debug_status_t st;
+
+    swd_set_config_permanently(NULL);
+    debug_status(&st);
+
+    return st.permanent ? E_NO_ERROR : E_BAD_STATE;
+}
+
+static int command_secureboot_status(int argc, char *argv[])
+{
+    secure_boot_is_enable(NULL);
+
+    return (infoblock_issecurebootenabled() == 1) ? E_NO_ERROR : E_BAD_STATE;
+}
+
+static int command_dump(int argc, char *argv[])
+{
+    const command_region_t *region = NULL;
+    const char *name = command_arg(argc, argv, "region");
+    uint8_t chunk[COMMAND_FLASH_CHUNK];
+    const uint8_t *data;
+    uint32_t offset, length, address, count;
+    unsigned int i;
+    int ret;
+
+    for (i = 0; name && (i < sizeof(command_regions) / sizeof(command_regions[0])); i++) {
+        if (strcmp(name, command_regions[i].name) == 0) {
+            region = &command_regions[i];
+        }
+    }
+    if (region == NULL) {
+        return E_BAD_PARAM;
+    }
+
+    if ((command_arg_uint(argc, argv, "off", &offset, 0) != E_NO_ERROR) ||
+        (offset >= region->length)) {
+        return E_BAD_PARAM;
+    }
+    if ((command_arg_uint(argc, argv, "len", &length, region->length - offset) != E_NO_ERROR) ||
+        (length == 0) || (length > region->length - offset)) {
+        return E_BAD_PARAM;
+    }
+
+    if (region->flash) {
+        address = HAL_FLASH_ADDRESS + region->offset + offset;
+        terminal_block_begin(region->name, address, length);
+        while (length) {
+            count = (length > sizeof(chunk)) ? sizeof(chunk) : length;
+            hal_flash_read(address, chunk, count);
+            terminal_block_data(address, chunk, count, region->flags);
+            address += count;
+            length -= count;
+        }
+        terminal_block_end();
+        ret = E_NO_ERROR;
+    } else {
+        if ((ret = infoblock_session_open()) != E_NO_ERROR) {
+            return ret;
+        }
+        address = HAL_INFOBLOCK_ADDRESS + region->offset + offset;
+        if ((data = infoblock_session_view(region->offset + offset, length)) == NULL) {
+            infoblock_session_close();
+            return E_BAD_STATE;
+        }
+        terminal_block_begin(region->name, address, length);
+        terminal_block_data(address, data, length, region->flags);
+        terminal_block_end();
+        ret = infoblock_session_close();
+    }
+
+    if (!terminal_get_binary()) {
+        terminal_printf("\r\n");
+    }
+
+    return ret;
+}
+
+static int command_binary(int argc, char *argv[])
+{
+    if ((argc != 2) || (strcmp(argv[1], "on") && strcmp(argv[1], "off"))) {
+        return E_BAD_PARAM;
+    }
+    terminal_set_binary(strcmp(argv[1], "on") == 0);
+
+    return E_NO_ERROR;
+}
+
+static int command_compress(int argc, char *argv[])
+{
+    if ((argc != 2) || (strcmp(argv[1], "on") && strcmp(argv[1], "off"))) {
+        return E_BAD_PARAM;
+    }
+    terminal_set_compress(strcmp(argv[1], "on") == 0);
+
+    return E_NO_ERROR;
+}
+
+/*
+ * Split a command into whitespace separated arguments, returns the argument count
+ */
+static int command_split(char *command, char *argv[])
+{
+    int argc = 0;
+
+    while (*command) {
+        while ((*command == ' ') || (*command == '\t')) {
+            *command++ = '\0';
+        }
+        if (*command == '\0') {
+            break;
+        }
+        if (argc == COMMAND_MAX_ARGS) {
+            return -1;
+        }
+        argv[argc++] = command;
+        while (*command && (*command != ' ') && (*command != '\t')) {
+            command++;
+        }
+    }
+
+    return argc;
+}
+
+static void command_reply(const char *name, int status, uint32_t cycles)
+{
+    uint32_t us = (uint32_t)(((uint64_t)cycles * 1000000u) / hal_cycles_hz());
+
+    terminal_printf("RES %s status=%d us=%u\r\n", name, status, (unsigned int)us);
+}
+
+/******************************* Public Functions ****************************/
+const char *command_arg(int argc, char *argv[], const char *key)
+{
+    size_t keylen = strlen(key);
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if ((strncmp(argv[i], key, keylen) == 0) && (argv[i][keylen] == '=')) {
+            return &argv[i][keylen + 1];
+        }
+    }
+
+    return NULL;
+}
+
+int command_arg_uint(int argc, char *argv[], const char *key, uint32_t *value, uint32_t defval)
+{
+    const char *text = command_arg(argc, argv, key);
+    char *end;
+
+    if (text == NULL) {
+        *value = defval;
+        return E_NO_ERROR;
+    }
+
+    *value = strtoul(text, &end, 0);
+    if ((*text == '\0') || (*end != '\0')) {
+        return E_BAD_PARAM;
+    }
+
+    return E_NO_ERROR;
+}
+
+int command_execute_line(char *line)
+{
+    char *argv[COMMAND_MAX_ARGS];
+    char *command, *next;
+    const command_t *entry;
+    int argc;
+    int status, result = E_NO_ERROR;
+    uint32_t start;
+    unsigned int i;
+
+    for (command = line; command; command = next) {
+        if ((next = strchr(command, ';')) != NULL) {
+            *next++ = '\0';
+        }
+
+        if ((argc = command_split(command, argv)) == 0) {
+            continue;
+        }
+        if (argc < 0) {
+            command_reply(argv[0], E_BAD_PARAM, 0);
+            result = (result == E_NO_ERROR) ? E_BAD_PARAM : result;
+            continue;
+        }
+
+        // Keep the reply sequence complete for the host, but run nothing after a failure
+        if (result != E_NO_ERROR) {
+            command_reply(argv[0], E_ABORT, 0);
+            continue;
+        }
+
+        entry = NULL;
+        for (i = 0; i < sizeof(command_table) / sizeof(command_table[0]); i++) {
+            if (strcmp(argv[0], command_table[i].name) == 0) {
+                entry = &command_table[i];
+                break;
+            }
+        }
+
+        start = hal_cycles();
+        if (entry == NULL) {
+            status = E_NOT_SUPPORTED;
+        } else if (entry->handler) {
+            status = entry->handler(argc, argv);
+        } else {
+            status = (argc == 1) ? entry->menu(entry->name) : E_BAD_PARAM;
+        }
+        command_reply(argv[0], status, hal_cycles() - start);
+
+        result = status;
+    }
+
+    return result;
+}
+
+int command_loop(void)
+{
+    char line[COMMAND_MAX_LINE];
+
+    command_done = 0;
+    terminal_printf("\r\nCOMMAND MODE\r\n");
+
+    while (!command_done) {
+        terminal_read_line(line, sizeof(line));
+        command_execute_line(line);
+    }
+
+    return E_NO_ERROR;
+}
@@ -0,0 +1,230 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "infoblock.h"
+#include "hal.h"
+#include "probe.h"
+
+/**
+ * CRC15 lookup tables for polynomial 0x4599 (CRC-15/CAN), MSB first.
+ *
+ * crc15_table_lo[x] is the CRC15 of the single byte x starting from zero.
+ * crc15_table_hi[x] is the CRC15 of the two bytes {x, 0x00} starting from zero.
+ *
+ * Together they let crc15_bytes() consume 16 bits per lookup pair: the register
+ * is folded into the top 15 bits of the next 16-bit input word, and the result
+ * is crc15_table_hi[w >> 8] ^ crc15_table_lo[w & 0xFF].
+ *
+ * The tables are constant data so they cost no start-up time; they were produced
+ * with the bit-serial routine below and are checked against it by crc15_selftest().
+ */
+static const uint16_t crc15_table_lo[256] = {
+    0x0000, 0x4599, 0x4EAB, 0x0B32, 0x58CF, 0x1D56, 0x1664, 0x53FD,
+    0x7407, 0x319E, 0x3AAC, 0x7F35, 0x2CC8, 0x6951, 0x6263, 0x27FA,
+    0x2D97, 0x680E, 0x633C, 0x26A5, 0x7558, 0x30C1, 0x3BF3, 0x7E6A,
+    0x5990, 0x1C09, 0x173B, 0x52A2, 0x015F, 0x44C6, 0x4FF4, 0x0A6D,
+    0x5B2E, 0x1EB7, 0x1585, 0x501C, 0x03E1, 0x4678, 0x4D4A, 0x08D3,
+    0x2F29, 0x6AB0, 0x6182, 0x241B, 0x77E6, 0x327F, 0x394D, 0x7CD4,
+    0x76B9, 0x3320, 0x3812, 0x7D8B, 0x2E76, 0x6BEF, 0x60DD, 0x2544,
+    0x02BE, 0x4727, 0x4C15, 0x098C, 0x5A71, 0x1FE8, 0x14DA, 0x5143,
+    0x73C5, 0x365C, 0x3D6E, 0x78F7, 0x2B0A, 0x6E93, 0x65A1, 0x2038,
+    0x07C2, 0x425B, 0x4969, 0x0CF0, 0x5F0D, 0x1A94, 0x11A6, 0x543F,
+    0x5E52, 0x1BCB, 0x10F9, 0x5560, 0x069D, 0x4304, 0x4836, 0x0DAF,
+    0x2A55, 0x6FCC, 0x64FE, 0x2167, 0x729A, 0x3703, 0x3C31, 0x79A8,
+    0x28EB, 0x6D72, 0x6640, 0x23D9, 0x7024, 0x35BD, 0x3E8F, 0x7B16,
+    0x5CEC, 0x1975, 0x1247, 0x57DE, 0x0423, 0x41BA, 0x4A88, 0x0F11,
+    0x057C, 0x40E5, 0x4BD7, 0x0E4E, 0x5DB3, 0x182A, 0x1318, 0x5681,
+    0x717B, 0x34E2, 0x3FD0, 0x7A49, 0x29B4, 0x6C2D, 0x671F, 0x2286,
+    0x2213, 0x678A, 0x6CB8, 0x2921, 0x7ADC, 0x3F45, 0x3477, 0x71EE,
+    0x5614, 0x138D, 0x18BF, 0x5D26, 0x0EDB, 0x4B42, 0x4070, 0x05E9,
+    0x0F84, 0x4A1D, 0x412F, 0x04B6, 0x574B, 0x12D2, 0x19E0, 0x5C79,
+    0x7B83, 0x3E1A, 0x3528, 0x70B1, 0x234C, 0x66D5, 0x6DE7, 0x287E,
+    0x793D, 0x3CA4, 0x3796, 0x720F, 0x21F2, 0x646B, 0x6F59, 0x2AC0,
+    0x0D3A, 0x48A3, 0x4391, 0x0608, 0x55F5, 0x106C, 0x1B5E, 0x5EC7,
+    0x54AA, 0x1133, 0x1A01, 0x5F98, 0x0C65, 0x49FC, 0x42CE, 0x0757,
+    0x20AD, 0x6534, 0x6E06, 0x2B9F, 0x7862, 0x3DFB, 0x36C9, 0x7350,
+    0x51D6, 0x144F, 0x1F7D, 0x5AE4, 0x0919, 0x4C80, 0x47B2, 0x022B,
+    0x25D1, 0x6048, 0x6B7A, 0x2EE3, 0x7D1E, 0x3887, 0x33B5, 0x762C,
+    0x7C41, 0x39D8, 0x32EA, 0x7773, 0x248E, 0x6117, 0x6A25, 0x2FBC,
+    0x0846, 0x4DDF, 0x46ED, 0x0374, 0x5089, 0x1510, 0x1E22, 0x5BBB,
+    0x0AF8, 0x4F61, 0x4453, 0x01CA, 0x5237, 0x17AE, 0x1C9C, 0x5905,
+    0x7EFF, 0x3B66, 0x3054, 0x75CD, 0x2630, 0x63A9, 0x689B, 0x2D02,
+    0x276F, 0x62F6, 0x69C4, 0x2C5D, 0x7FA0, 0x3A39, 0x310B, 0x7492,
+    0x5368, 0x16F1, 0x1DC3, 0x585A, 0x0BA7, 0x4E3E, 0x450C, 0x0095,
+};
+
+static const uint16_t crc15_table_hi[256] = {
+    0x0000, 0x4426, 0x4DD5, 0x09F3, 0x5E33, 0x1A15, 0x13E6, 0x57C0,
+    0x79FF, 0x3DD9, 0x342A, 0x700C, 0x27CC, 0x63EA, 0x6A19, 0x2E3F,
+    0x3667, 0x7241, 0x7BB2, 0x3F94, 0x6854, 0x2C72, 0x2581, 0x61A7,
+    0x4F98, 0x0BBE, 0x024D, 0x466B, 0x11AB, 0x558D, 0x5C7E, 0x1858,
+    0x6CCE, 0x28E8, 0x211B, 0x653D, 0x32FD, 0x76DB, 0x7F28, 0x3B0E,
+    0x1531, 0x5117, 0x58E4, 0x1CC2, 0x4B02, 0x0F24, 0x06D7, 0x42F1,
+    0x5AA9, 0x1E8F, 0x177C, 0x535A, 0x049A, 0x40BC, 0x494F, 0x0D69,
+    0x2356, 0x6770, 0x6E83, 0x2AA5, 0x7D65, 0x3943, 0x30B0, 0x7496,
+    0x1C05, 0x5823, 0x51D0, 0x15F6, 0x4236, 0x0610, 0x0FE3, 0x4BC5,
+    0x65FA, 0x21DC, 0x282F, 0x6C09, 0x3BC9, 0x7FEF, 0x761C, 0x323A,
+    0x2A62, 0x6E44, 0x67B7, 0x2391, 0x7451, 0x3077, 0x3984, 0x7DA2,
+    0x539D, 0x17BB, 0x1E48, 0x5A6E, 0x0DAE, 0x4988, 0x407B, 0x045D,
+    0x70CB, 0x34ED, 0x3D1E, 0x7938, 0x2EF8, 0x6ADE, 0x632D, 0x270B,
+    0x0934, 0x4D12, 0x44E1, 0x00C7, 0x5707, 0x1321, 0x1AD2, 0x5EF4,
+    0x46AC, 0x028A, 0x0B79, 0x4F5F, 0x189F, 0x5CB9, 0x554A, 0x116C,
+    0x3F53, 0x7B75, 0x7286, 0x36A0, 0x6160, 0x2546, 0x2CB5, 0x6893,
+    0x380A, 0x7C2C, 0x75DF, 0x31F9, 0x6639, 0x221F, 0x2BEC, 0x6FCA,
+    0x41F5, 0x05D3, 0x0C20, 0x4806, 0x1FC6, 0x5BE0, 0x5213, 0x1635,
+    0x0E6D, 0x4A4B, 0x43B8, 0x079E, 0x505E, 0x1478, 0x1D8B, 0x59AD,
+    0x7792, 0x33B4, 0x3A47, 0x7E61, 0x29A1, 0x6D87, 0x6474, 0x2052,
+    0x54C4, 0x10E2, 0x1911, 0x5D37, 0x0AF7, 0x4ED1, 0x4722, 0x0304,
+    0x2D3B, 0x691D, 0x60EE, 0x24C8, 0x7308, 0x372E, 0x3EDD, 0x7AFB,
+    0x62A3, 0x2685, 0x2F76, 0x6B50, 0x3C90, 0x78B6, 0x7145, 0x3563,
+    0x1B5C, 0x5F7A, 0x5689, 0x12AF, 0x456F, 0x0149, 0x08BA, 0x4C9C,
+    0x240F, 0x6029, 0x69DA, 0x2DFC, 0x7A3C, 0x3E1A, 0x37E9, 0x73CF,
+    0x5DF0, 0x19D6, 0x1025, 0x5403, 0x03C3, 0x47E5, 0x4E16, 0x0A30,
+    0x1268, 0x564E, 0x5FBD, 0x1B9B, 0x4C5B, 0x087D, 0x018E, 0x45A8,
+    0x6B97, 0x2FB1, 0x2642, 0x6264, 0x35A4, 0x7182, 0x7871, 0x3C57,
+    0x48C1, 0x0CE7, 0x0514, 0x4132, 0x16F2, 0x52D4, 0x5B27, 0x1F01,
+    0x313E, 0x7518, 0x7CEB, 0x38CD, 0x6F0D, 0x2B2B, 0x22D8, 0x66FE,
+    0x7EA6, 0x3A80, 0x3373, 0x7755, 0x2095, 0x64B3, 0x6D40, 0x2966,
+    0x0759, 0x437F, 0x4A8C, 0x0EAA, 0x596A, 0x1D4C, 0x14BF, 0x5099,
+};
+
+/*
+ * Reference bit-serial implementation. Only used for partial bytes and by the self test.
+ */
+static uint16_t crc15_bitserial(uint16_t crc15val, const uint8_t *input, int bitlength)
+{
+    uint16_t inputbit;
+    uint16_t feedbackbit;
+    int i;
+
+    for (i = 0; i < bitlength; i++) {
+        inputbit = (input[i / 8] >> (7 - i % 8)) & 0x01;
+        feedbackbit = ((crc15val & 0x4000) >> 14) & 0x01;
+        crc15val <<= 1;
+        if (inputbit ^ feedbackbit) {
+            crc15val ^= CRC15_POLY;
+        }
+    }
+    // Clean up.
+    // Mask off any high bits we were ignoring in the loop.
+    crc15val &= 0x7FFF;
+
+    return crc15val;
+}
+
+uint16_t crc15_bytes(uint16_t crc15val, const uint8_t *input, int length)
+{
+    uint16_t word;
+
+    crc15val &= 0x7FFF;
+
+    // Two bytes per step
+    while (length >= 2) {
+        word = (uint16_t)(crc15val << 1) ^ (uint16_t)((input[0] << 8) | input[1]);
+        crc15val = crc15_table_hi[word >> 8] ^ crc15_table_lo[word & 0xFF];
+        input += 2;
+        length -= 2;
+    }
+
+    // Odd trailing byte
+    if (length) {
+        crc15val = ((crc15val << 8) ^ crc15_table_lo[((crc15val >> 7) ^ input[0]) & 0xFF]) & 0x7FFF;
+    }
+
+    return crc15val;
+}
+
+uint16_t crc15_highbitinput(uint16_t crc15val, uint8_t *input, int bitlength)
+{
+    // Whole bytes go through the tables, any remaining high bits of the last byte bit by bit.
+    crc15val = crc15_bytes(crc15val, input, bitlength / 8);
+    if (bitlength % 8) {
+        crc15val = crc15_bitserial(crc15val, input + bitlength / 8, bitlength % 8);
+    }
+
+    return crc15val;
+}
+
+uint16_t crc15_designline(const uint8_t *line)
+{
+    uint16_t crc15val;
+    uint16_t word;
+    PROBE_BEGIN(PROBE_INFOBLOCK_CRC);
+
+    // Lock bit is high bit, bit 63. Starting from zero, one input bit
+    // either leaves the register empty or loads the polynomial.
+    crc15val = (line[7] & 0x80) ? CRC15_POLY : 0;
+
+    // Then the data from high to low bits (bit 47 to 0), bytes 5..0, 16 bits at a time.
+    word = (uint16_t)(crc15val << 1) ^ (uint16_t)((line[5] << 8) | line[4]);
+    crc15val = crc15_table_hi[word >> 8] ^ crc15_table_lo[word & 0xFF];
+    word = (uint16_t)(crc15val << 1) ^ (uint16_t)((line[3] << 8) | line[2]);
+    crc15val = crc15_table_hi[word >> 8] ^ crc15_table_lo[word & 0xFF];
+    word = (uint16_t)(crc15val << 1) ^ (uint16_t)((line[1] << 8) | line[0]);
+    crc15val = crc15_table_hi[word >> 8] ^ crc15_table_lo[word & 0xFF];
+
+    PROBE_END(PROBE_INFOBLOCK_CRC);
+
+    return crc15val;
+}
+
+int crc15_selftest(void)
+{
+    static const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    uint8_t line[INFOBLOCK_LINE_SIZE];
+    uint32_t lfsr = 0xACE1ACE1;
+    uint16_t reference;
+    int i, j, bits;
+
+    // Known answer, CRC-15/CAN check value
+    if (crc15_bitserial(0, check, 8 * sizeof(check)) != CRC15_CHECK_VALUE) {
+        return E_BAD_STATE;
+    }
+    if (crc15_bytes(0, check, sizeof(check)) != CRC15_CHECK_VALUE) {
+        return E_BAD_STATE;
+    }
+
+    for (i = 0; i < 256; i++) {
+        // Pseudo random line content, including both states of the lock bit
+        for (j = 0; j < INFOBLOCK_LINE_SIZE; j++) {
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xEDB88320);
+            line[j] = (uint8_t)lfsr;
+        }
+
+        // Design line fast path against the original lock bit + 6 bytes sequence
+        reference = crc15_bitserial(0, line + 7, 1);
+        for (j = 5; j >= 0; j--) {
+            reference = crc15_bitserial(reference, line + j, 8);
+        }
+        if (crc15_designline(line) != reference) {
+            return E_BAD_STATE;
+        }
+
+        // Generic entry point for every bit length and a non-zero start value
+        bits = 1 + (i % (8 * INFOBLOCK_LINE_SIZE));
+        reference = crc15_bitserial(reference, line, bits);
+        if (crc15_highbitinput(crc15_designline(line), line, bits) != reference) {
+            return E_BAD_STATE;
+        }
+    }
+
+    return E_NO_ERROR;
+}
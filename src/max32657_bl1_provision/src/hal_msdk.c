@@ -0,0 +1,263 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************      INCLUDES    ****************************/
+#include <stdio.h>
+#include <stdint.h>
+
+#include "mxc_device.h"
+#include "mcr_regs.h" // For BBREG0 register.
+#include "flc.h"
+#include "uart.h"
+#include "mxc_delay.h"
+
+#include "hal.h"
+#include "infoblock.h"
+
+/*******************************      DEFINES     ****************************/
+#define PC_COM_PORT MXC_UART
+#define PC_COM_CLOCK MXC_UART_APB_CLK
+// The UART samples every bit this many times, the divisor below it is unusable
+#define UART_MIN_DIVISOR 8
+
+/*******************************    Variables   ****************************/
+static hal_uart_tx_callback_t hal_uart_tx_callback;
+
+/******************************* Public Functions ****************************/
+int hal_init(void)
+{
+    // Start the DWT cycle counter behind hal_cycles()
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    return E_NO_ERROR;
+}
+
+uint32_t hal_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t hal_cycles_hz(void)
+{
+    return SystemCoreClock;
+}
+
+void hal_halt(void)
+{
+    while (1) {
+        ;
+    }
+}
+
+int hal_infoblock_unlock(void)
+{
+    return MXC_FLC_UnlockInfoBlock(MXC_INFO_MEM_BASE);
+}
+
+int hal_infoblock_lock(void)
+{
+    return MXC_FLC_LockInfoBlock(MXC_INFO_MEM_BASE);
+}
+
+const uint8_t *hal_infoblock_view(uint32_t offset)
+{
+    return (const uint8_t *)(MXC_INFO_MEM_BASE + offset);
+}
+
+int hal_infoblock_write128(uint32_t offset, uint32_t *data)
+{
+    return MXC_FLC_Write128(MXC_INFO_MEM_BASE + offset, data);
+}
+
+int hal_infoblock_erase_user(void)
+{
+    return MXC_FLC_PageErase(MXC_INFO_MEM_BASE + INFOBLOCK_USER_SECTION_OFFSET);
+}
+
+void hal_flash_read(uint32_t address, uint8_t *data, uint32_t length)
+{
+    MXC_FLC_Read(address, data, length);
+}
+
+int hal_flash_mass_erase(void)
+{
+    return MXC_FLC_MassErase();
+}
+
+int hal_uart_init(unsigned int baud)
+{
+    return MXC_UART_Init(PC_COM_PORT, baud, MXC_UART_IBRO_CLK);
+}
+
+int hal_uart_read_char(void)
+{
+    return MXC_UART_ReadCharacter(PC_COM_PORT);
+}
+
+int hal_uart_write_char(uint8_t c)
+{
+    return MXC_UART_WriteCharacter(PC_COM_PORT, c);
+}
+
+int hal_uart_write(const uint8_t *data, int *length)
+{
+    return MXC_UART_Write(PC_COM_PORT, (uint8_t *)data, length);
+}
+
+void hal_uart_clear_rx(void)
+{
+    MXC_UART_ClearRXFIFO(PC_COM_PORT);
+}
+
+int hal_uart_read_char_timeout(unsigned int timeout_ms)
+{
+    unsigned int polls = timeout_ms * 100;
+    int c;
+
+    do {
+        if ((c = MXC_UART_ReadCharacterRaw(PC_COM_PORT)) >= 0) {
+            return c;
+        }
+        MXC_Delay(MXC_DELAY_USEC(10));
+    } while (polls--);
+
+    return E_TIME_OUT;
+}
+
+int hal_uart_get_baud(void)
+{
+    return MXC_UART_GetFrequency(PC_COM_PORT);
+}
+
+unsigned int hal_uart_baud_actual(unsigned int baud)
+{
+    unsigned int divisor;
+
+    if (baud == 0) {
+        return 0;
+    }
+
+    // Integer divisor of the peripheral clock, rounded to nearest
+    divisor = (PeripheralClock + baud / 2) / baud;
+    if (divisor < UART_MIN_DIVISOR) {
+        return 0;
+    }
+
+    return PeripheralClock / divisor;
+}
+
+int hal_uart_set_baud(unsigned int baud)
+{
+    int ret;
+
+    if ((ret = MXC_UART_SetFrequency(PC_COM_PORT, baud, PC_COM_CLOCK)) < 0) {
+        return ret;
+    }
+
+    return MXC_UART_GetFrequency(PC_COM_PORT);
+}
+
+void hal_uart_tx_wait_idle(void)
+{
+    while (MXC_UART_GetActive(PC_COM_PORT) == E_BUSY) {}
+}
+
+static void hal_uart_irqhandler(void)
+{
+    MXC_UART_ClearFlags(PC_COM_PORT, MXC_UART_GetFlags(PC_COM_PORT) & MXC_F_UART_INT_FL_TX_HE);
+
+    if (hal_uart_tx_callback) {
+        hal_uart_tx_callback();
+    }
+}
+
+int hal_uart_tx_async_init(hal_uart_tx_callback_t callback)
+{
+    MXC_UART_DisableInt(PC_COM_PORT, MXC_F_UART_INT_EN_TX_HE);
+    hal_uart_tx_callback = callback;
+
+    MXC_NVIC_SetVector(UART_IRQn, hal_uart_irqhandler);
+    NVIC_EnableIRQ(UART_IRQn);
+
+    return E_NO_ERROR;
+}
+
+void hal_uart_tx_irq_enable(int enable)
+{
+    if (enable) {
+        MXC_UART_EnableInt(PC_COM_PORT, MXC_F_UART_INT_EN_TX_HE);
+    } else {
+        MXC_UART_DisableInt(PC_COM_PORT, MXC_F_UART_INT_EN_TX_HE);
+    }
+}
+
+int hal_uart_tx_fifo_write(const uint8_t *data, int length)
+{
+    return (int)MXC_UART_WriteTXFIFO(PC_COM_PORT, data, (unsigned int)length);
+}
+
+uint32_t hal_mcr_bypass_read(int index)
+{
+    return (index == 0) ? MXC_MCR->bypass0 : MXC_MCR->bypass1;
+}
+
+void hal_mcr_bypass_write(int index, uint32_t value)
+{
+    if (index == 0) {
+        MXC_MCR->bypass0 = value;
+    } else {
+        MXC_MCR->bypass1 = value;
+    }
+}
+
+uint32_t hal_mcr_bypass_address(int index)
+{
+    return (index == 0) ? (uint32_t)&MXC_MCR->bypass0 : (uint32_t)&MXC_MCR->bypass1;
+}
+
+uint8_t *hal_pubkey(unsigned int *length)
+{
+    extern unsigned char _p_key_start[]; // defined in linker script
+    extern unsigned char _p_key_end; // defined in linker script
+
+    *length = (&_p_key_end - _p_key_start);
+
+    return _p_key_start;
+}
+
+uint8_t *hal_mailbox_params(unsigned int *length)
+{
+    extern unsigned char _mailbox_params_start[]; // defined in linker script
+    extern unsigned char _mailbox_params_end; // defined in linker script
+
+    *length = (&_mailbox_params_end - _mailbox_params_start);
+
+    return _mailbox_params_start;
+}
+
+uint8_t *hal_mailbox_result(unsigned int *length)
+{
+    extern unsigned char _mailbox_result_start[]; // defined in linker script
+    extern unsigned char _mailbox_result_end; // defined in linker script
+
+    *length = (&_mailbox_result_end - _mailbox_result_start);
+
+    return _mailbox_result_start;
+}
@@ -20,107 +20,366 @@
 #include <stdint.h>
 #include <string.h>
 #include "infoblock.h"
-#include "mxc_device.h"
-#include "flc.h"
-
-uint16_t crc15_highbitinput(uint16_t crc15val, uint8_t *input, int bitlength)
+#include "hal.h"
+#include "probe.h"
+
+/*
+ * Layout of the information block, sorted by offset.
+ * infoblock_read() and infoblock_write() accept any line aligned offset inside a region.
+ */
+static const infoblock_region_t infoblock_regions[] = {
+    { INFOBLOCK_USN_OFFSET, INFOBLOCK_USN_REGION_SIZE, INFOBLOCK_LINE_FORMAT_USN, FALSE, FALSE,
+      INFOBLOCK_WRITE_LOCK_LINE_SIZE },
+    { INFOBLOCK_FMV_OFFSET, INFOBLOCK_FMV_REGION_SIZE, INFOBLOCK_LINE_FORMAT_RAW, FALSE, FALSE,
+      INFOBLOCK_WRITE_LOCK_LINE_SIZE },
+    { INFOBLOCK_ICE_LOCK_OFFSET, INFOBLOCK_ICE_LOCK_REGION_SIZE, INFOBLOCK_LINE_FORMAT_RAW, FALSE,
+      TRUE, INFOBLOCK_WRITE_LOCK_LINE_SIZE },
+    { INFOBLOCK_KEY_OFFSET, INFOBLOCK_KEY_REGION_SIZE, INFOBLOCK_LINE_FORMAT_DESIGN, FALSE, TRUE,
+      INFOBLOCK_LINE_SIZE },
+    { INFOBLOCK_USER_SECTION_OFFSET, INFOBLOCK_USER_SECTION_SIZE, INFOBLOCK_LINE_FORMAT_RAW, TRUE,
+      TRUE, INFOBLOCK_WRITE_LOCK_LINE_SIZE },
+};
+
+// Regions must be made of whole lines, in order and without overlap.
+#define INFOBLOCK_REGION_ALIGNED(offset, length) \
+    ((((offset) % INFOBLOCK_LINE_SIZE) == 0) && (((length) % INFOBLOCK_LINE_SIZE) == 0))
+_Static_assert(INFOBLOCK_REGION_ALIGNED(INFOBLOCK_USN_OFFSET, INFOBLOCK_USN_REGION_SIZE),
+               "USN region not line aligned");
+_Static_assert(INFOBLOCK_REGION_ALIGNED(INFOBLOCK_FMV_OFFSET, INFOBLOCK_FMV_REGION_SIZE),
+               "FMV region not line aligned");
+_Static_assert(INFOBLOCK_REGION_ALIGNED(INFOBLOCK_ICE_LOCK_OFFSET, INFOBLOCK_ICE_LOCK_REGION_SIZE),
+               "ICE lock region not line aligned");
+_Static_assert(INFOBLOCK_REGION_ALIGNED(INFOBLOCK_KEY_OFFSET, INFOBLOCK_KEY_REGION_SIZE),
+               "Key region not line aligned");
+_Static_assert(INFOBLOCK_REGION_ALIGNED(INFOBLOCK_USER_SECTION_OFFSET, INFOBLOCK_USER_SECTION_SIZE),
+               "User region not line aligned");
+_Static_assert(INFOBLOCK_USN_OFFSET + INFOBLOCK_USN_REGION_SIZE <= INFOBLOCK_FMV_OFFSET,
+               "USN region overlaps FMV region");
+_Static_assert(INFOBLOCK_FMV_OFFSET + INFOBLOCK_FMV_REGION_SIZE <= INFOBLOCK_ICE_LOCK_OFFSET,
+               "FMV region overlaps ICE lock region");
+_Static_assert(INFOBLOCK_ICE_LOCK_OFFSET + INFOBLOCK_ICE_LOCK_REGION_SIZE <= INFOBLOCK_KEY_OFFSET,
+               "ICE lock region overlaps key region");
+_Static_assert(INFOBLOCK_KEY_OFFSET + INFOBLOCK_KEY_REGION_SIZE <= INFOBLOCK_USER_SECTION_OFFSET,
+               "Key region overlaps user region");
+_Static_assert(INFOBLOCK_USER_SECTION_OFFSET + INFOBLOCK_USER_SECTION_SIZE <= INFOBLOCK_SIZE,
+               "User region outside the information block");
+_Static_assert((INFOBLOCK_ICE_LOCK_OFFSET % INFOBLOCK_WRITE_LOCK_LINE_SIZE) == 0,
+               "ICE lock region must start a write lock line");
+_Static_assert(INFOBLOCK_SHADOW_DEVICE_SIZE >= INFOBLOCK_ICE_LOCK_OFFSET + INFOBLOCK_ICE_LOCK_REGION_SIZE,
+               "Device shadow does not cover the ICE lock region");
+
+static unsigned int infoblock_session_depth = 0;
+static unsigned int infoblock_session_unlocked = FALSE;
+
+#ifdef INFOBLOCK_SHADOW_CACHE
+/*
+ * SRAM copies of the information block lines used by the status queries.
+ * Each range is snapshotted from flash on first use. Lines are invalidated
+ * when they are programmed and fetched again on the next access.
+ */
+typedef struct {
+    uint32_t offset; /**< start of the shadowed range in the infoblock */
+    uint32_t length; /**< length of the range, at most 32 lines */
+    uint8_t *lines; /**< SRAM copy of the range */
+    uint32_t valid; /**< one bit per line, set when the copy matches flash */
+    uint32_t crcchecked; /**< one bit per line, set when the DESIGN CRC15 of the copy was verified */
+} infoblock_shadow_t;
+
+static uint32_t infoblock_shadow_device[INFOBLOCK_SHADOW_DEVICE_SIZE / sizeof(uint32_t)];
+static uint32_t infoblock_shadow_key[INFOBLOCK_SHADOW_KEY_SIZE / sizeof(uint32_t)];
+
+static infoblock_shadow_t infoblock_shadow[] = {
+    { INFOBLOCK_USN_OFFSET, INFOBLOCK_SHADOW_DEVICE_SIZE, (uint8_t *)infoblock_shadow_device, 0,
+      0 },
+    { INFOBLOCK_KEY_OFFSET, INFOBLOCK_SHADOW_KEY_SIZE, (uint8_t *)infoblock_shadow_key, 0, 0 },
+};
+
+static infoblock_shadow_t *infoblock_shadow_find(uint32_t offset, uint32_t length)
 {
-    uint16_t inputbit;
-    uint16_t feedbackbit;
     int i;
 
-    for (i = 0; i < bitlength; i++) {
-        inputbit = (input[i / 8] >> (7 - i % 8)) & 0x01;
-        feedbackbit = ((crc15val & 0x4000) >> 14) & 0x01;
-        crc15val <<= 1;
-        if (inputbit ^ feedbackbit) {
-            crc15val ^= 0x4599;
+    for (i = 0; i < sizeof(infoblock_shadow) / sizeof(infoblock_shadow[0]); i++) {
+        if ((offset >= infoblock_shadow[i].offset) &&
+            ((offset + length) <= (infoblock_shadow[i].offset + infoblock_shadow[i].length))) {
+            return &infoblock_shadow[i];
         }
     }
-    // Clean up.
-    // Mask off any high bits we were ignoring in the loop.
-    crc15val &= 0x7FFF;
 
-    return crc15val;
+    return NULL;
 }
 
-int infoblock_readraw(uint32_t offset, uint8_t *data)
+static uint32_t infoblock_shadow_linemask(infoblock_shadow_t *shadow, uint32_t offset,
+                                          uint32_t length)
+{
+    uint32_t first, last;
+
+    first = (offset - shadow->offset) / INFOBLOCK_LINE_SIZE;
+    last = (offset + length - 1 - shadow->offset) / INFOBLOCK_LINE_SIZE;
+
+    return (uint32_t)((((uint64_t)1 << (last + 1)) - 1) & ~(((uint64_t)1 << first) - 1));
+}
+#endif /* INFOBLOCK_SHADOW_CACHE */
+
+/*
+ * Make sure the flash controller gives access to the information block, must be called within a session.
+ */
+static int infoblock_session_access(void)
 {
     int result;
 
-    result = infoblock_unlock(MXC_INFO_MEM_BASE);
-    if (result != E_NO_ERROR) {
-        return result;
+    if (infoblock_session_depth == 0) {
+        return E_BAD_STATE;
     }
-    memcpy(data, (uint8_t *)(MXC_INFO_MEM_BASE + offset), INFOBLOCK_LINE_SIZE);
 
-    result = infoblock_lock(MXC_INFO_MEM_BASE);
+    // Only the first access of the outermost session touches the flash controller
+    if (infoblock_session_unlocked == FALSE) {
+        if ((result = infoblock_unlock(HAL_INFOBLOCK_ADDRESS)) != E_NO_ERROR) {
+            return result;
+        }
+        infoblock_session_unlocked = TRUE;
+    }
 
-    return result;
+    return E_NO_ERROR;
 }
 
-int infoblock_read(uint32_t offset, uint8_t *data, int length)
+int infoblock_session_open(void)
 {
-    uint8_t oneinfoblockline[INFOBLOCK_LINE_SIZE];
-    int lengthtocopy;
-    uint16_t crc = 0;
-    uint16_t crcexpected;
+    infoblock_session_depth++;
+
+    return E_NO_ERROR;
+}
+
+int infoblock_session_close(void)
+{
+    if (infoblock_session_depth == 0) {
+        return E_BAD_STATE;
+    }
+
+    // Only the outermost close locks the information block again, if it was unlocked at all
+    if ((--infoblock_session_depth == 0) && (infoblock_session_unlocked == TRUE)) {
+        infoblock_session_unlocked = FALSE;
+        return infoblock_lock(HAL_INFOBLOCK_ADDRESS);
+    }
+
+    return E_NO_ERROR;
+}
+
+const uint8_t *infoblock_session_view(uint32_t offset, uint32_t length)
+{
+#ifdef INFOBLOCK_SHADOW_CACHE
+    infoblock_shadow_t *shadow;
+    uint32_t mask;
+#endif
+
+    if (infoblock_session_depth == 0) {
+        return NULL;
+    }
+
+    if ((length == 0) || (offset > INFOBLOCK_SIZE) || (length > (INFOBLOCK_SIZE - offset))) {
+        return NULL;
+    }
+
+#ifdef INFOBLOCK_SHADOW_CACHE
+    if ((shadow = infoblock_shadow_find(offset, length)) != NULL) {
+        mask = infoblock_shadow_linemask(shadow, offset, length);
+        if ((shadow->valid & mask) != mask) {
+            // Snapshot the whole range, lines that were already valid keep their CRC state
+            if (infoblock_session_access() != E_NO_ERROR) {
+                return NULL;
+            }
+            memcpy(shadow->lines, hal_infoblock_view(shadow->offset), shadow->length);
+            shadow->crcchecked &= shadow->valid;
+            shadow->valid = infoblock_shadow_linemask(shadow, shadow->offset, shadow->length);
+        }
+        return shadow->lines + (offset - shadow->offset);
+    }
+#endif
+
+    if (infoblock_session_access() != E_NO_ERROR) {
+        return NULL;
+    }
+
+    return hal_infoblock_view(offset);
+}
+
+void infoblock_shadow_invalidate(uint32_t offset, uint32_t length)
+{
+#ifdef INFOBLOCK_SHADOW_CACHE
     int i;
+    uint32_t start, end;
+
+    for (i = 0; i < sizeof(infoblock_shadow) / sizeof(infoblock_shadow[0]); i++) {
+        // Clip the range to this shadow
+        start = (offset > infoblock_shadow[i].offset) ? offset : infoblock_shadow[i].offset;
+        end = infoblock_shadow[i].offset + infoblock_shadow[i].length;
+        if ((offset + length) < end) {
+            end = offset + length;
+        }
+        if (start < end) {
+            infoblock_shadow[i].valid &=
+                ~infoblock_shadow_linemask(&infoblock_shadow[i], start, end - start);
+        }
+    }
+#else
+    (void)offset;
+    (void)length;
+#endif
+}
+
+/*
+ * Check whether the DESIGN CRC15 of a line was already verified on the current shadow copy.
+ */
+static int infoblock_shadow_crcchecked(uint32_t offset)
+{
+#ifdef INFOBLOCK_SHADOW_CACHE
+    infoblock_shadow_t *shadow;
+    uint32_t mask;
+
+    if ((shadow = infoblock_shadow_find(offset, INFOBLOCK_LINE_SIZE)) != NULL) {
+        mask = infoblock_shadow_linemask(shadow, offset, INFOBLOCK_LINE_SIZE);
+        return ((shadow->valid & shadow->crcchecked & mask) != 0) ? TRUE : FALSE;
+    }
+#else
+    (void)offset;
+#endif
+
+    return FALSE;
+}
+
+/*
+ * Remember that the DESIGN CRC15 of a line was verified on the current shadow copy.
+ */
+static void infoblock_shadow_setcrcchecked(uint32_t offset)
+{
+#ifdef INFOBLOCK_SHADOW_CACHE
+    infoblock_shadow_t *shadow;
+
+    if ((shadow = infoblock_shadow_find(offset, INFOBLOCK_LINE_SIZE)) != NULL) {
+        shadow->crcchecked |= infoblock_shadow_linemask(shadow, offset, INFOBLOCK_LINE_SIZE);
+    }
+#else
+    (void)offset;
+#endif
+}
+
+const infoblock_region_t *infoblock_region_find(uint32_t offset)
+{
+    int low = 0;
+    int high = (sizeof(infoblock_regions) / sizeof(infoblock_regions[0])) - 1;
+    int middle;
+
+    // Binary search, regions are sorted and do not overlap
+    while (low <= high) {
+        middle = (low + high) / 2;
+        if (offset < infoblock_regions[middle].offset) {
+            high = middle - 1;
+        } else if (offset >= (infoblock_regions[middle].offset + infoblock_regions[middle].length)) {
+            low = middle + 1;
+        } else {
+            return &infoblock_regions[middle];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Number of payload bytes carried by one line of the given format.
+ */
+static int infoblock_linepayload(lineformat_e lineformat)
+{
+    return (lineformat == INFOBLOCK_LINE_FORMAT_RAW) ? INFOBLOCK_LINE_SIZE :
+                                                      (INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD);
+}
+
+/*
+ * Check a formatted access of length payload bytes at offset, returns its region or NULL.
+ */
+static const infoblock_region_t *infoblock_region_check(uint32_t offset, int length)
+{
+    const infoblock_region_t *region;
+    int lengthperline;
+
+    if (((region = infoblock_region_find(offset)) == NULL) || (offset % INFOBLOCK_LINE_SIZE)) {
+        return NULL;
+    }
+
+    lengthperline = infoblock_linepayload(region->lineformat);
+    if ((length > 0) && (((length + lengthperline - 1) / lengthperline) >
+                         ((region->offset + region->length - offset) / INFOBLOCK_LINE_SIZE))) {
+        return NULL;
+    }
+
+    return region;
+}
+
+int infoblock_readraw(uint32_t offset, uint8_t *data)
+{
     int result;
-    lineformat_e lineformat;
+    const uint8_t *line;
 
-    if (length > INFOBLOCK_MAXIMUM_READ_LENGTH) {
-        return E_BAD_PARAM;
+    if ((result = infoblock_session_open()) != E_NO_ERROR) {
+        return result;
     }
 
-    if (data == NULL) {
-        return E_BAD_PARAM;
+    line = infoblock_session_view(offset, INFOBLOCK_LINE_SIZE);
+    if (line != NULL) {
+        memcpy(data, line, INFOBLOCK_LINE_SIZE);
+    } else {
+        result = E_BAD_PARAM;
     }
 
-    switch (offset) {
-    case INFOBLOCK_USN_OFFSET:
-        lineformat = INFOBLOCK_LINE_FORMAT_USN;
-        break;
-    case INFOBLOCK_FMV_OFFSET:
-    case INFOBLOCK_ICE_LOCK_OFFSET:
-        lineformat = INFOBLOCK_LINE_FORMAT_RAW;
-        break;
-    case INFOBLOCK_KEY_OFFSET:
-        lineformat = INFOBLOCK_LINE_FORMAT_DESIGN;
-        break;
-    default:
-        return E_BAD_PARAM;
-        break;
+    if (infoblock_session_close() != E_NO_ERROR) {
+        return E_BAD_STATE;
     }
 
+    return result;
+}
+
+/*
+ * Decode formatted lines straight from the information block, must be called within a session.
+ */
+static int infoblock_readlines(uint32_t offset, const infoblock_region_t *region, uint8_t *data,
+                               int length)
+{
+    const uint8_t *line;
+    uint8_t usnline[INFOBLOCK_LINE_SIZE];
+    const uint8_t *linedata;
+    int lengthtocopy;
+    uint16_t crc = 0;
+    uint16_t crcexpected;
+    int i;
+
     while (length > 0) {
-        if ((result = infoblock_readraw(offset, oneinfoblockline)) != E_NO_ERROR) {
-            return result;
+        if ((line = infoblock_session_view(offset, INFOBLOCK_LINE_SIZE)) == NULL) {
+            return E_BAD_PARAM;
         }
 
-        switch (lineformat) {
+        switch (region->lineformat) {
         case INFOBLOCK_LINE_FORMAT_USN:
             // NO CRC15, ignore lowest 15 bits
             // Lock bit is high bit, bit 63.
             // Data is middle 48 bits 62 to 15.
             // CRC15 is lower 15 bits (bits 0-14)
             // First shift data one bit left starting at the high byte.
+            memcpy(usnline, line, INFOBLOCK_LINE_SIZE);
             for (i = 7; i > 1; i--) {
-                oneinfoblockline[i] <<= 1;
-                oneinfoblockline[i] |= (oneinfoblockline[i - 1] & 0x80) >> 7;
+                usnline[i] <<= 1;
+                usnline[i] |= (usnline[i - 1] & 0x80) >> 7;
             }
-            // Then, shift data by two bytes
-            memmove(oneinfoblockline, oneinfoblockline + INFOBLOCK_LINE_OVERHEAD, 6);
+            // Then, skip the two low bytes
+            linedata = usnline + INFOBLOCK_LINE_OVERHEAD;
             lengthtocopy = INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD;
             break;
         case INFOBLOCK_LINE_FORMAT_RAW:
+            linedata = line;
             lengthtocopy = INFOBLOCK_LINE_SIZE;
             break;
         case INFOBLOCK_LINE_FORMAT_DESIGN:
             // Check for unprogrammed information block line
             crc = 0xFF;
-            for (i = 0; i < sizeof(oneinfoblockline); i++) {
-                crc &= oneinfoblockline[i];
+            for (i = 0; i < INFOBLOCK_LINE_SIZE; i++) {
+                crc &= line[i];
             }
             if (crc == 0xFF) {
                 // Line is unprogrammed, return error.
@@ -130,16 +389,17 @@ int infoblock_read(uint32_t offset, uint8_t *data, int length)
             // Lock bit is high bit, bit 63.
             // CRC15 is middle 15 bits [62:48]
             // Data is lower 48 bits [47:0].
-            // First, CRC the lock bit.
-            crc = crc15_highbitinput(0, oneinfoblockline + 7, 1);
-            // Then CRC the data from high to low bits.  (bit 47 to 0)
-            for (i = 5; i >= 0; i--) {
-                crc = crc15_highbitinput(crc, oneinfoblockline + i, 8);
-            }
-            crcexpected = ((oneinfoblockline[7] & 0x7F) << 8) | oneinfoblockline[6];
-            if (crc != crcexpected) {
-                return E_BAD_STATE;
+            // CRC the lock bit, then the data from high to low bits.  (bit 47 to 0)
+            // Skipped when the shadow copy of this line was already verified.
+            if (infoblock_shadow_crcchecked(offset) == FALSE) {
+                crc = crc15_designline(line);
+                crcexpected = ((line[7] & 0x7F) << 8) | line[6];
+                if (crc != crcexpected) {
+                    return E_BAD_STATE;
+                }
+                infoblock_shadow_setcrcchecked(offset);
             }
+            linedata = line;
             lengthtocopy = INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD;
             break;
         default:
@@ -151,7 +411,12 @@ int infoblock_read(uint32_t offset, uint8_t *data, int length)
         if (lengthtocopy > length) {
             lengthtocopy = length;
         }
-        memcpy(data, oneinfoblockline, lengthtocopy);
+        memcpy(data, linedata, lengthtocopy);
+        if (region->inverted) {
+            for (i = 0; i < lengthtocopy; i++) {
+                data[i] ^= 0xFF;
+            }
+        }
         data += lengthtocopy;
         length -= lengthtocopy;
         offset += INFOBLOCK_LINE_SIZE;
@@ -160,6 +425,36 @@ int infoblock_read(uint32_t offset, uint8_t *data, int length)
     return E_NO_ERROR;
 }
 
+int infoblock_read(uint32_t offset, uint8_t *data, int length)
+{
+    int result;
+    const infoblock_region_t *region;
+
+    if (data == NULL) {
+        return E_BAD_PARAM;
+    }
+
+    if ((region = infoblock_region_check(offset, length)) == NULL) {
+        return E_BAD_PARAM;
+    }
+
+    PROBE_BEGIN(PROBE_INFOBLOCK_READ);
+
+    if ((result = infoblock_session_open()) != E_NO_ERROR) {
+        return result;
+    }
+
+    result = infoblock_readlines(offset, region, data, length);
+
+    if (infoblock_session_close() != E_NO_ERROR) {
+        return E_BAD_STATE;
+    }
+
+    PROBE_END(PROBE_INFOBLOCK_READ);
+
+    return result;
+}
+
 int infoblock_checkenable_generic(int offset, int minimumpatterncount)
 {
     int i;
@@ -198,62 +493,66 @@ int infoblock_checkenable_icelock()
 
 int infoblock_checkpermicelock()
 {
-    // Make space to read entire flash line to check the flash line lock.
-    uint8_t data[INFOBLOCK_WRITE_LOCK_LINE_SIZE];
-    uint32_t infooffset, offset, length;
+    const uint8_t *data;
+    uint32_t infooffset;
+    int result = FALSE;
 
     // To enable secure boot
     // 1. ICE_LOCK must be enabled AND
     // 2. ICE_LOCK must be permanent (flash line lock enabled).
 
-    // First, check to see if ICE_LOCK is enabled (ICE is locked out).
-    if (infoblock_checkenable_icelock() == FALSE) {
+    if (infoblock_session_open() != E_NO_ERROR) {
         return FALSE;
     }
 
-    // Then, check to see if the last bit of the write lock line is cleared (bit clear makes word read-only)
-    offset = 0;
-    length = INFOBLOCK_WRITE_LOCK_LINE_SIZE;
-    // Get the proper aligned write lock line address which contains the ICE_LOCK word.
-    infooffset = INFOBLOCK_ICE_LOCK_OFFSET & ~(INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1);
-    // Read as many INFOBOCK lines which fit into the INFOBLOCK write lock lines.
-    // NOTE: On MAX32655, this will do 2 reads because the flash is 128-bit wide.
-    // INFOBLOCK Write lock lines are thus 128 bits and the INFOBLOCK storage lines are 64-bit.
-    while (length > 0) {
-        if (infoblock_readraw(infooffset, data + offset) != E_NO_ERROR) {
-            return FALSE;
+    // First, check to see if ICE_LOCK is enabled (ICE is locked out).
+    if (infoblock_checkenable_icelock() == TRUE) {
+        // Then, check to see if the last bit of the write lock line is cleared (bit clear makes word read-only)
+        // Get the proper aligned write lock line address which contains the ICE_LOCK word.
+        // NOTE: On MAX32655, the write lock line spans two INFOBLOCK lines because the flash is 128-bit wide.
+        // INFOBLOCK Write lock lines are thus 128 bits and the INFOBLOCK storage lines are 64-bit.
+        infooffset = INFOBLOCK_ICE_LOCK_OFFSET & ~(INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1);
+        data = infoblock_session_view(infooffset, INFOBLOCK_WRITE_LOCK_LINE_SIZE);
+
+        // Check for zero lock bit (last bit of last byte in flash line).
+        if ((data != NULL) && ((data[INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1] & 0x80) == 0)) {
+            result = TRUE;
         }
-        infooffset += INFOBLOCK_LINE_SIZE;
-        offset += INFOBLOCK_LINE_SIZE;
-        length -= INFOBLOCK_LINE_SIZE;
     }
 
-    // Check for zero lock bit (last bit of last byte in flash line).
-    if ((data[INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1] & 0x80) == 0) {
-        return TRUE;
-    }
+    infoblock_session_close();
 
-    return FALSE;
+    return result;
 }
 
 int infoblock_issecurebootenabled()
 {
-    uint32_t oneinfoblockline[INFOBLOCK_LINE_SIZE / sizeof(uint32_t)];
+    const uint32_t *oneinfoblockline;
     int i;
     uint32_t valueand;
     int keylength, infooffset;
+    int result = FALSE;
 
     // Device is in Secure/Closed Mode if
     // 1. Key area of Information Block is written.
     // 2. ICE_LOCK is locked and Information Block Line Write bit is cleared. (bit 127)
     //
+    if (infoblock_session_open() != E_NO_ERROR) {
+        return FALSE;
+    }
+
     // Read the raw key area of information block and see if it has been programmed.
     valueand = 0xFFFFFFFF;
     keylength = INFOBLOCK_KEY_SIZE;
     infooffset = INFOBLOCK_KEY_OFFSET;
     while (keylength > 0) {
-        // Read one information block line.
-        infoblock_readraw(infooffset, (uint8_t *)oneinfoblockline);
+        // View one information block line.
+        oneinfoblockline =
+            (const uint32_t *)infoblock_session_view(infooffset, INFOBLOCK_LINE_SIZE);
+        if (oneinfoblockline == NULL) {
+            valueand = 0xFFFFFFFF;
+            break;
+        }
 
         // Loop across key and accumulate zeros and ones.
         for (i = 0; i < (INFOBLOCK_LINE_SIZE / sizeof(uint32_t)); i++) {
@@ -262,128 +561,409 @@ int infoblock_issecurebootenabled()
         infooffset += INFOBLOCK_LINE_SIZE;
         keylength -= (INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD);
     }
+
     // If key had all 1s, it is not programmed and the device is not in Secure Mode.
-    if (valueand == 0xFFFFFFFF) {
-        return FALSE;
-    }
-    // Key has been programmed, now check permanent ICE LOCK (aka SWD disable).
-    if (infoblock_checkpermicelock() == TRUE) {
+    // Otherwise key has been programmed, now check permanent ICE LOCK (aka SWD disable).
+    if ((valueand != 0xFFFFFFFF) && (infoblock_checkpermicelock() == TRUE)) {
         // Key exists and ICE is locked out permanently.
+        result = TRUE;
+    }
+
+    infoblock_session_close();
+
+    return result;
+}
+
+/*
+ * A line is write locked when the lock bit of its 128-bit flash word is cleared,
+ * or when the lock bit of its region's lock unit is cleared.
+ */
+static int infoblock_linelocked(uint32_t offset)
+{
+    const infoblock_region_t *region;
+    const uint8_t *unit;
+    uint32_t granularity;
+
+    unit = infoblock_session_view(offset & ~(INFOBLOCK_FLASH_WORD_SIZE - 1),
+                                  INFOBLOCK_FLASH_WORD_SIZE);
+    if ((unit == NULL) || ((unit[INFOBLOCK_FLASH_WORD_SIZE - 1] & 0x80) == 0)) {
         return TRUE;
-    } else {
-        return FALSE;
     }
+
+    if ((region = infoblock_region_find(offset)) != NULL) {
+        granularity = region->lockgranularity;
+        unit = infoblock_session_view(offset & ~(granularity - 1), granularity);
+        if ((unit == NULL) || ((unit[granularity - 1] & 0x80) == 0)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
 }
 
-int infoblock_writeraw(uint32_t offset, uint32_t *data)
+int infoblock_plan(uint32_t offset, const uint8_t *image, int numlines, uint32_t *programlines)
 {
+    const uint8_t *current;
     int result;
-    int writeresult = E_NO_ERROR;
+    int i, j;
 
-    if ((result = infoblock_unlock(MXC_INFO_MEM_BASE)) != E_NO_ERROR) {
-        return result;
+    if ((image == NULL) || (programlines == NULL) || (numlines < 0) ||
+        (numlines > INFOBLOCK_PLAN_MAX_LINES) || (offset % INFOBLOCK_LINE_SIZE)) {
+        return E_BAD_PARAM;
     }
 
-    writeresult = MXC_FLC_Write((MXC_INFO_MEM_BASE + offset), INFOBLOCK_LINE_SIZE, data);
+    if ((offset > INFOBLOCK_SIZE) ||
+        (numlines > (INFOBLOCK_SIZE - offset) / INFOBLOCK_LINE_SIZE)) {
+        return E_BAD_PARAM;
+    }
 
-    if ((result = infoblock_lock(MXC_INFO_MEM_BASE)) != E_NO_ERROR) {
+    if ((result = infoblock_session_open()) != E_NO_ERROR) {
         return result;
     }
 
+    *programlines = 0;
+    for (i = 0; (i < numlines) && (result == E_NO_ERROR);
+         i++, offset += INFOBLOCK_LINE_SIZE, image += INFOBLOCK_LINE_SIZE) {
+        if ((current = infoblock_session_view(offset, INFOBLOCK_LINE_SIZE)) == NULL) {
+            result = E_BAD_STATE;
+            break;
+        }
+
+        // Already holds the target, nothing to program
+        if (memcmp(current, image, INFOBLOCK_LINE_SIZE) == 0) {
+            continue;
+        }
+
+        // Programming can only clear bits
+        for (j = 0; j < INFOBLOCK_LINE_SIZE; j++) {
+            if (image[j] & ~current[j]) {
+                result = E_BAD_STATE;
+                break;
+            }
+        }
+
+        if ((result == E_NO_ERROR) && infoblock_linelocked(offset)) {
+            result = E_BAD_STATE;
+        }
+
+        *programlines |= 1UL << i;
+    }
+
+    if (infoblock_session_close() != E_NO_ERROR) {
+        return E_BAD_STATE;
+    }
+
+    return result;
+}
+
+/*
+ * Program consecutive lines, numlines must be at least one.
+ */
+static int infoblock_programlines(uint32_t offset, const uint8_t *data, int numlines)
+{
+    uint32_t flashword[INFOBLOCK_FLASH_WORD_SIZE / sizeof(uint32_t)];
+    const uint8_t *current;
+    uint32_t wordoffset;
+    int linesused;
+    int writeresult = E_NO_ERROR;
+
+    while ((numlines > 0) && (writeresult == E_NO_ERROR)) {
+        wordoffset = offset & ~(INFOBLOCK_FLASH_WORD_SIZE - 1);
+
+        if ((wordoffset == offset) && (numlines >= 2)) {
+            // Two adjacent lines fill a whole 128-bit flash word
+            memcpy(flashword, data, INFOBLOCK_FLASH_WORD_SIZE);
+            linesused = 2;
+        } else {
+            // Single line, program the other half of the flash word with its current contents
+            if ((current = infoblock_session_view(wordoffset, INFOBLOCK_FLASH_WORD_SIZE)) == NULL) {
+                return E_BAD_STATE;
+            }
+            memcpy(flashword, current, INFOBLOCK_FLASH_WORD_SIZE);
+            memcpy((uint8_t *)flashword + (offset - wordoffset), data, INFOBLOCK_LINE_SIZE);
+            linesused = 1;
+        }
+        PROBE_BEGIN(PROBE_FLC_WRITE);
+        writeresult = hal_infoblock_write128(wordoffset, flashword);
+        PROBE_END(PROBE_FLC_WRITE);
+
+        // Whatever the outcome, the shadow copy of these lines can no longer be trusted
+        infoblock_shadow_invalidate(offset, linesused * INFOBLOCK_LINE_SIZE);
+
+        offset += linesused * INFOBLOCK_LINE_SIZE;
+        data += linesused * INFOBLOCK_LINE_SIZE;
+        numlines -= linesused;
+    }
+
     return writeresult;
 }
 
-int infoblock_write(uint32_t offset, uint8_t *data, int length)
+int infoblock_writerawlines(uint32_t offset, uint32_t *data, int numlines)
 {
-    uint32_t oneinfoblockline_32[INFOBLOCK_LINE_SIZE / sizeof(uint32_t)];
-    uint8_t *oneinfoblockline = (uint8_t *)oneinfoblockline_32;
-    int lengthtowrite;
-    uint16_t crc = 0;
-    int i;
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t programlines;
+    int chunk, done, first, last;
     int result;
-    lineformat_e lineformat;
+    int writeresult = E_NO_ERROR;
 
-    if (length > INFOBLOCK_MAXIMUM_READ_LENGTH) {
+    if ((data == NULL) || (numlines < 0) || (offset % INFOBLOCK_LINE_SIZE)) {
         return E_BAD_PARAM;
     }
 
-    if (data == NULL) {
+    if ((offset > INFOBLOCK_SIZE) ||
+        (numlines > (INFOBLOCK_SIZE - offset) / INFOBLOCK_LINE_SIZE)) {
         return E_BAD_PARAM;
     }
 
-    switch (offset) {
-    case INFOBLOCK_ICE_LOCK_OFFSET:
-        lineformat = INFOBLOCK_LINE_FORMAT_RAW;
+    if ((result = infoblock_session_open()) != E_NO_ERROR) {
+        return result;
+    }
+
+    // Plan every line first so nothing is programmed when any line is out of reach
+    for (done = 0; (done < numlines) && (writeresult == E_NO_ERROR); done += chunk) {
+        chunk = numlines - done;
+        chunk = (chunk > INFOBLOCK_PLAN_MAX_LINES) ? INFOBLOCK_PLAN_MAX_LINES : chunk;
+        writeresult = infoblock_plan(offset + done * INFOBLOCK_LINE_SIZE,
+                                     bytes + done * INFOBLOCK_LINE_SIZE, chunk, &programlines);
+    }
+
+    if (writeresult == E_NO_ERROR) {
+        writeresult = infoblock_session_access();
+    }
+
+    // Then program only the runs of lines that differ from the current contents
+    for (done = 0; (done < numlines) && (writeresult == E_NO_ERROR); done += chunk) {
+        chunk = numlines - done;
+        chunk = (chunk > INFOBLOCK_PLAN_MAX_LINES) ? INFOBLOCK_PLAN_MAX_LINES : chunk;
+        writeresult = infoblock_plan(offset + done * INFOBLOCK_LINE_SIZE,
+                                     bytes + done * INFOBLOCK_LINE_SIZE, chunk, &programlines);
+
+        for (first = 0; (first < chunk) && (writeresult == E_NO_ERROR); first = last) {
+            if (!(programlines & (1UL << first))) {
+                last = first + 1;
+                continue;
+            }
+            for (last = first + 1; (last < chunk) && (programlines & (1UL << last)); last++) {}
+
+            writeresult = infoblock_programlines(offset + (done + first) * INFOBLOCK_LINE_SIZE,
+                                                 bytes + (done + first) * INFOBLOCK_LINE_SIZE,
+                                                 last - first);
+        }
+    }
+
+    if ((result = infoblock_session_close()) != E_NO_ERROR) {
+        return result;
+    }
+
+    return writeresult;
+}
+
+int infoblock_writeraw(uint32_t offset, uint32_t *data)
+{
+    return infoblock_writerawlines(offset, data, 1);
+}
+
+/*
+ * Format one line of data (up to a full line of payload) for the given line format.
+ */
+static int infoblock_formatline(const infoblock_region_t *region, uint8_t *oneinfoblockline,
+                                uint8_t *data, int lengthtowrite)
+{
+    uint16_t crc = 0;
+    int i;
+
+    // RAW lines leave bytes past the payload unprogrammed
+    memset(oneinfoblockline, (region->lineformat == INFOBLOCK_LINE_FORMAT_RAW) ? 0xFF : 0,
+           INFOBLOCK_LINE_SIZE);
+    for (i = 0; i < lengthtowrite; i++) {
+        oneinfoblockline[i] = region->inverted ? (data[i] ^ 0xFF) : data[i];
+    }
+
+    switch (region->lineformat) {
+    case INFOBLOCK_LINE_FORMAT_RAW:
+        // No change to oneinfoblockline
         break;
-    case INFOBLOCK_KEY_OFFSET:
-        lineformat = INFOBLOCK_LINE_FORMAT_DESIGN;
+    case INFOBLOCK_LINE_FORMAT_DESIGN:
+        // Lock bit is high bit, bit 63.
+        // CRC15 is middle 15 bits [62:48]
+        // Data is lower 48 bits [47:0].
+        // CRC the lock bit, then the data from high to low bits.  (bit 47 to 0) =  6 bytes (5..0)
+        crc = crc15_designline(oneinfoblockline);
+        oneinfoblockline[7] &= ~0x7F; // keep only the lock bit
+        oneinfoblockline[7] |= crc >> 8; // put in the top 7 bits of CRC
+        oneinfoblockline[6] = (uint8_t)crc; // bottom 8 bits of crc
         break;
     default:
-        return E_BAD_PARAM;
+        // NOTE: Should never get here.
+        return E_BAD_STATE;
         break;
     }
 
-    while (length > 0) {
-        switch (lineformat) {
-        case INFOBLOCK_LINE_FORMAT_RAW:
-            lengthtowrite = INFOBLOCK_LINE_SIZE;
-            break;
-        case INFOBLOCK_LINE_FORMAT_DESIGN:
-            lengthtowrite = INFOBLOCK_LINE_SIZE - INFOBLOCK_LINE_OVERHEAD;
-            break;
-        default:
-            // NOTE: Should never get here.
-            return E_BAD_STATE;
-            break;
-        }
+    return E_NO_ERROR;
+}
+
+/*
+ * Read back numlines programmed lines and compare them with what was intended.
+ * Bit n of the returned mask is set when line (firstline + n) does not match.
+ */
+static uint32_t infoblock_verifylines(uint32_t offset, const infoblock_region_t *region,
+                                      const uint8_t *expected, int numlines, int firstline)
+{
+    const uint8_t *line;
+    uint32_t failedlines = 0;
+    uint16_t crc;
+    int i;
 
-        if (lengthtowrite > length) {
-            lengthtowrite = length;
+    for (i = 0; i < numlines; i++, offset += INFOBLOCK_LINE_SIZE, expected += INFOBLOCK_LINE_SIZE) {
+        line = infoblock_session_view(offset, INFOBLOCK_LINE_SIZE);
+        if ((line == NULL) || memcmp(line, expected, INFOBLOCK_LINE_SIZE)) {
+            failedlines |= 1UL << (firstline + i);
+            continue;
         }
-        memset(oneinfoblockline, 0, INFOBLOCK_LINE_SIZE);
-        memcpy(oneinfoblockline, data, lengthtowrite);
 
-        switch (lineformat) {
-        case INFOBLOCK_LINE_FORMAT_RAW:
-            // No change to oneinfoblockline
-            break;
-        case INFOBLOCK_LINE_FORMAT_DESIGN:
-            // Lock bit is high bit, bit 63.
-            // CRC15 is middle 15 bits [62:48]
-            // Data is lower 48 bits [47:0].
-            // First, CRC the lock bit.
-            crc = crc15_highbitinput(0, oneinfoblockline + 7, 1);
-            // Then CRC the data from high to low bits.  (bit 47 to 0) =  6 bytes (5..0)
-            for (i = 5; i >= 0; i--) {
-                crc = crc15_highbitinput(crc, oneinfoblockline + i, 8);
+        if (region->lineformat == INFOBLOCK_LINE_FORMAT_DESIGN) {
+            crc = ((line[7] & 0x7F) << 8) | line[6];
+            if (crc != crc15_designline(line)) {
+                failedlines |= 1UL << (firstline + i);
             }
-            oneinfoblockline[7] &= ~0x7F; // keep only the lock bit
-            oneinfoblockline[7] |= crc >> 8; // put in the top 7 bits of CRC
-            oneinfoblockline[6] = (uint8_t)crc; // bottom 8 bits of crc
-            break;
-        default:
-            // NOTE: Should never get here.
-            return E_BAD_STATE;
-            break;
         }
+    }
+
+    return failedlines;
+}
+
+/*
+ * Format and program length bytes of data, verifying every line when failedlines is not NULL.
+ */
+static int infoblock_writelines(uint32_t offset, uint8_t *data, int length, uint32_t *failedlines)
+{
+    uint32_t batch_32[INFOBLOCK_WRITE_BATCH_LINES * INFOBLOCK_LINE_SIZE / sizeof(uint32_t)];
+    uint8_t *batch = (uint8_t *)batch_32;
+    uint32_t batchoffset, nextoffset;
+    uint32_t planoffset, programlines;
+    uint8_t *plandata;
+    int planlength;
+    int numlines, linesdone;
+    int lengthperline, lengthtowrite;
+    int result = E_NO_ERROR;
+    const infoblock_region_t *region;
+
+    if (data == NULL) {
+        return E_BAD_PARAM;
+    }
+
+    // The whole payload must fit in a writable region, nothing is programmed otherwise
+    if (((region = infoblock_region_check(offset, length)) == NULL) || !region->writable) {
+        return E_BAD_PARAM;
+    }
+    lengthperline = infoblock_linepayload(region->lineformat);
 
-        if ((result = infoblock_writeraw(offset, oneinfoblockline_32)) != E_NO_ERROR) {
+    if ((failedlines != NULL) &&
+        (((length + lengthperline - 1) / lengthperline) > INFOBLOCK_VERIFY_MAX_LINES)) {
+        return E_BAD_PARAM;
+    }
+
+    if ((result = infoblock_session_open()) != E_NO_ERROR) {
+        return result;
+    }
+
+    // Plan every formatted line first, nothing is programmed if any line is out of reach
+    for (planoffset = offset, planlength = length, plandata = data; planlength > 0;
+         planoffset += INFOBLOCK_LINE_SIZE) {
+        lengthtowrite = (lengthperline > planlength) ? planlength : lengthperline;
+        if (((result = infoblock_formatline(region, batch, plandata, lengthtowrite)) !=
+             E_NO_ERROR) ||
+            ((result = infoblock_plan(planoffset, batch, 1, &programlines)) != E_NO_ERROR)) {
+            infoblock_session_close();
             return result;
         }
+        plandata += lengthtowrite;
+        planlength -= lengthtowrite;
+    }
+
+    batchoffset = offset;
+    numlines = 0;
+    linesdone = 0;
+    while (length > 0) {
+        lengthtowrite = (lengthperline > length) ? length : lengthperline;
+
+        result = infoblock_formatline(region, batch + numlines * INFOBLOCK_LINE_SIZE, data,
+                                      lengthtowrite);
+        if (result != E_NO_ERROR) {
+            break;
+        }
 
         data += lengthtowrite;
         length -= lengthtowrite;
-        offset += INFOBLOCK_LINE_SIZE;
+        numlines++;
+
+        // Program the batch when it is full, or one line early when that keeps
+        // the following batches aligned to 128-bit flash words.
+        nextoffset = batchoffset + numlines * INFOBLOCK_LINE_SIZE;
+        if ((length == 0) || (numlines == INFOBLOCK_WRITE_BATCH_LINES) ||
+            ((numlines == INFOBLOCK_WRITE_BATCH_LINES - 1) &&
+             !(nextoffset % INFOBLOCK_FLASH_WORD_SIZE))) {
+            if ((result = infoblock_writerawlines(batchoffset, batch_32, numlines)) !=
+                E_NO_ERROR) {
+                break;
+            }
+
+            // Stop programming as soon as a batch does not read back as intended
+            if (failedlines != NULL) {
+                *failedlines |=
+                    infoblock_verifylines(batchoffset, region, batch, numlines, linesdone);
+                if (*failedlines) {
+                    result = E_BAD_STATE;
+                    break;
+                }
+            }
+            linesdone += numlines;
+            batchoffset = nextoffset;
+            numlines = 0;
+        }
     }
 
-    return E_NO_ERROR;
+    if (infoblock_session_close() != E_NO_ERROR) {
+        return E_BAD_STATE;
+    }
+
+    return result;
+}
+
+int infoblock_write(uint32_t offset, uint8_t *data, int length)
+{
+    int result;
+
+    PROBE_BEGIN(PROBE_INFOBLOCK_WRITE);
+    result = infoblock_writelines(offset, data, length, NULL);
+    PROBE_END(PROBE_INFOBLOCK_WRITE);
+
+    return result;
+}
+
+int infoblock_write_verified(uint32_t offset, uint8_t *data, int length, uint32_t *failedlines)
+{
+    int result;
+
+    if (failedlines == NULL) {
+        return E_NULL_PTR;
+    }
+    // Valid on every return, error paths included
+    *failedlines = 0;
+
+    PROBE_BEGIN(PROBE_INFOBLOCK_WRITE);
+    result = infoblock_writelines(offset, data, length, failedlines);
+    PROBE_END(PROBE_INFOBLOCK_WRITE);
+
+    return result;
 }
 
 int infoblock_unlock(uint32_t address)
 {
     int ret;
 
-    ret = MXC_FLC_UnlockInfoBlock(address);
+    (void)address;
+    ret = hal_infoblock_unlock();
 
     return ret;
 }
@@ -392,7 +972,8 @@ int infoblock_lock(uint32_t address)
 {
     int ret;
 
-    ret = MXC_FLC_LockInfoBlock(address);
+    (void)address;
+    ret = hal_infoblock_lock();
 
     return ret;
 }
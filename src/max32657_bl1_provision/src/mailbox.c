@@ -0,0 +1,236 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************      INCLUDES    ****************************/
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "mailbox.h"
+#include "terminal.h"
+#include "infoblock.h"
+#include "swd_lock.h"
+#include "sha256.h"
+#include "probe.h"
+
+/*******************************    Variables   ****************************/
+// Copy of the accepted manifest, the mailbox itself may be overwritten by the host later
+static struct {
+    int status;
+    uint8_t key[MAILBOX_CRK_SIZE];
+    unsigned int keylen;
+    unsigned int lock;
+    uint32_t flags;
+} mailbox_params = { E_NONE_AVAIL, { 0 }, 0, MAILBOX_LOCK_PERMANENT, 0 };
+
+// Read by the host over SWD while the firmware runs, hence volatile
+static volatile mailbox_result_t *mailbox_result;
+static uint32_t mailbox_step_start;
+
+/******************************* Static Functions ****************************/
+static uint16_t mailbox_le16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static uint32_t mailbox_le32(const uint8_t *src)
+{
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static int mailbox_params_parse(const uint8_t *tlv, unsigned int length)
+{
+    unsigned int pos = 0;
+    uint16_t tag, len;
+
+    while (pos < length) {
+        if (length - pos < 4) {
+            return E_INVALID;
+        }
+        tag = mailbox_le16(&tlv[pos]);
+        len = mailbox_le16(&tlv[pos + 2]);
+        pos += 4;
+        if (len > length - pos) {
+            return E_INVALID;
+        }
+
+        switch (tag) {
+        case MAILBOX_TAG_CRK:
+            if (len != MAILBOX_CRK_SIZE) {
+                return E_INVALID;
+            }
+            memcpy(mailbox_params.key, &tlv[pos], len);
+            mailbox_params.keylen = len;
+            break;
+        case MAILBOX_TAG_LOCK_POLICY:
+            if ((len != 1) || (tlv[pos] > MAILBOX_LOCK_PERMANENT)) {
+                return E_INVALID;
+            }
+            mailbox_params.lock = tlv[pos];
+            break;
+        case MAILBOX_TAG_FLAGS:
+            if (len != 4) {
+                return E_INVALID;
+            }
+            mailbox_params.flags = mailbox_le32(&tlv[pos]);
+            break;
+        default:
+            // Added by a newer host, nothing this firmware needs
+            break;
+        }
+
+        pos += len;
+    }
+
+    return E_NO_ERROR;
+}
+
+/******************************* Public Functions ****************************/
+int mailbox_params_load(void)
+{
+    unsigned int size;
+    uint8_t *mailbox = hal_mailbox_params(&size);
+    uint16_t length;
+
+    if (mailbox_le32(mailbox) != MAILBOX_PARAMS_MAGIC) {
+        mailbox_params.status = E_NONE_AVAIL;
+        return mailbox_params.status;
+    }
+
+    // A manifest was written, anything wrong with it must stop provisioning
+    length = mailbox_le16(&mailbox[6]);
+    if ((mailbox_le16(&mailbox[4]) != MAILBOX_PARAMS_VERSION) ||
+        (length > size - MAILBOX_PARAMS_HEADER_SIZE) ||
+        (terminal_crc32(0, &mailbox[MAILBOX_PARAMS_HEADER_SIZE], length) !=
+         mailbox_le32(&mailbox[8]))) {
+        mailbox_params.status = E_INVALID;
+    } else {
+        mailbox_params.status = mailbox_params_parse(&mailbox[MAILBOX_PARAMS_HEADER_SIZE], length);
+    }
+
+    if (mailbox_params.status != E_NO_ERROR) {
+        mailbox_params.keylen = 0;
+        mailbox_params.lock = MAILBOX_LOCK_NONE;
+        mailbox_params.flags = 0;
+    }
+
+    memset(mailbox, 0, 4);
+
+    return mailbox_params.status;
+}
+
+int mailbox_params_status(void)
+{
+    return mailbox_params.status;
+}
+
+uint8_t *mailbox_key(unsigned int *length)
+{
+    if (mailbox_params.status == E_NONE_AVAIL) {
+        return hal_pubkey(length);
+    }
+
+    // A manifest without a CRK provisions nothing
+    *length = mailbox_params.keylen;
+
+    return mailbox_params.keylen ? mailbox_params.key : NULL;
+}
+
+unsigned int mailbox_lock_policy(void)
+{
+    return mailbox_params.lock;
+}
+
+uint32_t mailbox_flags(void)
+{
+    return mailbox_params.flags;
+}
+
+void mailbox_result_init(void)
+{
+    unsigned int size, i;
+
+    mailbox_result = (volatile mailbox_result_t *)hal_mailbox_result(&size);
+
+    mailbox_result->version = MAILBOX_RESULT_VERSION;
+    mailbox_result->phase = MAILBOX_PHASE_BOOT;
+    mailbox_result->status = MAILBOX_STATUS_NOT_RUN;
+    for (i = 0; i < MAILBOX_RESULT_STEPS; i++) {
+        mailbox_result->step_status[i] = MAILBOX_STATUS_NOT_RUN;
+        mailbox_result->step_cycles[i] = 0;
+    }
+    mailbox_result->cycles_hz = hal_cycles_hz();
+    mailbox_result->debug_locks = 0;
+    mailbox_result->debug_unlocks = 0;
+    mailbox_result->debug_locked = 0;
+    mailbox_result->debug_permanent = 0;
+    for (i = 0; i < sizeof(mailbox_result->usn); i++) {
+        mailbox_result->usn[i] = 0;
+    }
+    for (i = 0; i < sizeof(mailbox_result->crk_sha256); i++) {
+        mailbox_result->crk_sha256[i] = 0;
+    }
+
+    // Last, so the host never sees the magic over the fields of an earlier run
+    mailbox_result->magic = MAILBOX_RESULT_MAGIC;
+}
+
+void mailbox_result_begin(unsigned int phase)
+{
+    mailbox_result->phase = phase;
+    mailbox_step_start = hal_cycles();
+}
+
+void mailbox_result_end(unsigned int phase, int status)
+{
+    uint32_t cycles = hal_cycles() - mailbox_step_start;
+
+    mailbox_result->step_cycles[phase - 1] = cycles;
+    mailbox_result->step_status[phase - 1] = status;
+    PROBE_RECORD(PROBE_STEP_USN + (phase - MAILBOX_PHASE_USN), cycles);
+}
+
+void mailbox_result_finish(int status)
+{
+    uint8_t usn[INFOBLOCK_USN_LENGTH];
+    uint8_t key[INFOBLOCK_KEY_SIZE];
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    debug_status_t st;
+    unsigned int i;
+
+    if (infoblock_read(INFOBLOCK_USN_OFFSET, usn, sizeof(usn)) == E_NO_ERROR) {
+        for (i = 0; i < sizeof(usn); i++) {
+            mailbox_result->usn[i] = usn[i];
+        }
+    }
+    if (infoblock_read(INFOBLOCK_KEY_OFFSET, key, sizeof(key)) == E_NO_ERROR) {
+        sha256(key, sizeof(key), digest);
+        for (i = 0; i < sizeof(digest); i++) {
+            mailbox_result->crk_sha256[i] = digest[i];
+        }
+    }
+
+    debug_status(&st);
+    mailbox_result->debug_locks = st.locks;
+    mailbox_result->debug_unlocks = st.unlocks;
+    mailbox_result->debug_locked = st.locked;
+    mailbox_result->debug_permanent = st.permanent;
+    mailbox_result->status = status;
+
+    mailbox_result->phase = MAILBOX_PHASE_DONE;
+}
@@ -20,13 +20,14 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include "hal.h"
 #include "terminal.h"
 #include "infoblock.h"
+#include "command.h"
+#include "mailbox.h"
 
 //
 #define VERSION "v1.0.0"
-//
-#define USN_LEN 13
 
 /***** Functions *****/
 extern int provision_bootrom(void);
@@ -35,8 +36,10 @@ extern int test_menu(void);
 // *****************************************************************************
 int main(void)
 {
-    uint8_t usn[16];
+    uint8_t usn[INFOBLOCK_USN_LENGTH];
 
+    hal_init();
+    mailbox_result_init();
     terminal_init();
     terminal_printf("\r\n\r\n");
     terminal_printf("**** MAX32657 Secure Boot ROM Provisioning FW %s ****", VERSION);
@@ -45,21 +48,41 @@ int main(void)
     terminal_printf("date: '%s'\n\r", __DATE__);
     terminal_printf("time: '%s'\n\r", __TIME__);
 
-    int ret = infoblock_read(INFOBLOCK_USN_OFFSET, usn, USN_LEN);
+    mailbox_result_begin(MAILBOX_PHASE_USN);
+    int ret = infoblock_read(INFOBLOCK_USN_OFFSET, usn, sizeof(usn));
+    mailbox_result_end(MAILBOX_PHASE_USN, ret);
     if (ret == 0) {
-        terminal_hexdump("\n\rUSN:", (char *)usn, USN_LEN);
+        terminal_hexdump("\n\rUSN:", (char *)usn, sizeof(usn));
     } else {
         terminal_printf("\n\rError %d reading USN\r\n", ret);
+        terminal_flush();
+        mailbox_result_finish(ret);
         return -1;
     }
 
-    //
-    provision_bootrom();
+    mailbox_result_begin(MAILBOX_PHASE_PARAMS);
+    mailbox_result_end(MAILBOX_PHASE_PARAMS, mailbox_params_load());
 
-    //
-    //test_menu();
+#ifdef BL1_COMMAND_MODE
+    // Let the station drive every step, see command.h
+    ret = command_loop();
+#else
+    if (mailbox_flags() & MAILBOX_FLAG_COMMAND_MODE) {
+        ret = command_loop();
+    } else {
+        ret = provision_bootrom();
+    }
+#endif
+    // The console output is complete by the time the host sees the result
+    mailbox_result_begin(MAILBOX_PHASE_CONSOLE);
+    terminal_flush();
+    mailbox_result_end(MAILBOX_PHASE_CONSOLE, E_NO_ERROR);
+    mailbox_result_finish(ret);
 
-    while (1) {
-        ;
+    if (mailbox_flags() & MAILBOX_FLAG_TEST_MENU) {
+        test_menu();
     }
+
+    terminal_flush();
+    hal_halt();
 }
@@ -21,14 +21,14 @@
 #include <stdint.h>
 #include <string.h>
 
-#include "mxc_device.h"
-#include "mcr_regs.h" // For BBREG0 register.
-#include "flc.h"
-
+#include "hal.h"
 #include "menu_funcs.h"
 #include "terminal.h"
+#include "command.h"
 #include "infoblock.h"
 #include "swd_lock.h"
+#include "mailbox.h"
+#include "probe.h"
 
 //******************************************************************************
 int swd_lock(const char *parentName)
@@ -38,23 +38,24 @@ int swd_lock(const char *parentName)
     debug_status_t debug_stat;
 
     debug_locked = debug_status(&debug_stat);
-    terminal_printf("\n\rLocks left = %u, Unlocks left = %u, Debug port locked = %u\r\n",
-                    debug_stat.locks, debug_stat.unlocks, debug_stat.locked);
+    TERMINAL_LOG("\n\rLocks left = %u, Unlocks left = %u, Debug port locked = %u\r\n",
+                 debug_stat.locks, debug_stat.unlocks, debug_stat.locked);
     if (debug_locked) {
-        terminal_printf("Debug port is already Locked.\r\n");
+        TERMINAL_LOG("Debug port is already Locked.\r\n");
     } else {
-        terminal_printf("Debug port is Unlocked, attempting Lock.\r\n");
+        TERMINAL_LOG("Debug port is Unlocked, attempting Lock.\r\n");
         if (!debug_stat.locks) {
-            terminal_printf(
+            TERMINAL_LOG(
                 " Lock should fail, either no locks left or the permanent bit is set.\r\n");
         }
 
         debug_lock();
         debug_locked = debug_status(&debug_stat);
         if (debug_locked) {
-            terminal_printf("Debug port is now Locked.\r\n");
+            TERMINAL_LOG("Debug port is now Locked.\r\n");
         } else {
-            terminal_printf("Error: Debug port remains Unlocked.\r\n");
+            TERMINAL_LOG("Error: Debug port remains Unlocked.\r\n");
+            ret = E_BAD_STATE;
         }
     }
 
@@ -68,23 +69,23 @@ int swd_unlock(const char *parentName)
     debug_status_t debug_stat;
 
     debug_locked = debug_status(&debug_stat);
-    terminal_printf("\nLocks left = %u, Unlocks left = %u, Debug port locked = %u\r\n",
-                    debug_stat.locks, debug_stat.unlocks, debug_stat.locked);
+    TERMINAL_LOG("\nLocks left = %u, Unlocks left = %u, Debug port locked = %u\r\n",
+                 debug_stat.locks, debug_stat.unlocks, debug_stat.locked);
     if (debug_locked) {
-        terminal_printf("Debug port is Locked, attempting Unlock.\r\n");
+        TERMINAL_LOG("Debug port is Locked, attempting Unlock.\r\n");
         if (!debug_stat.unlocks) {
-            terminal_printf(
+            TERMINAL_LOG(
                 " Unlock should fail, either no unlocks left or the permanent bit is set.\r\n");
         }
         debug_unlock();
         debug_locked = debug_status(&debug_stat);
         if (debug_locked) {
-            terminal_printf("Error: Debug port is remains Locked.\r\n");
+            TERMINAL_LOG("Error: Debug port is remains Locked.\r\n");
         } else {
-            terminal_printf("Debug port is now Unlocked.\r\n");
+            TERMINAL_LOG("Debug port is now Unlocked.\r\n");
         }
     } else {
-        terminal_printf("Debug port already Unlocked. Nothing to do.\r\n");
+        TERMINAL_LOG("Debug port already Unlocked. Nothing to do.\r\n");
     }
 
     return ret;
@@ -98,20 +99,23 @@ int swd_set_config_permanently(const char *parentName)
 
     debug_locked = debug_status(&debug_stat);
 
-    terminal_printf("\n\rLocks left = %u, Unlocks left = %u, Debug port locked = %u\r\n",
-                    debug_stat.locks, debug_stat.unlocks, debug_stat.locked);
-    terminal_printf("Debug port is currently %s\r\n", debug_locked ? "Locked." : "Unlocked.");
-    terminal_printf("Will now permanently freeze the state.\r\n");
+    TERMINAL_LOG("\n\rLocks left = %u, Unlocks left = %u, Debug port locked = %u\r\n",
+                 debug_stat.locks, debug_stat.unlocks, debug_stat.locked);
+    TERMINAL_LOG("Debug port is currently %s\r\n", debug_locked ? "Locked." : "Unlocked.");
+    TERMINAL_LOG("Will now permanently freeze the state.\r\n");
 
     debug_set_config_permanently();
     debug_locked = debug_status(&debug_stat);
 
     if (debug_locked) {
-        terminal_printf("Debug port is Locked %s.\r\n",
-                        debug_stat.permanent ? "Permanently" : "NOT permanently");
+        TERMINAL_LOG("Debug port is Locked %s.\r\n",
+                     debug_stat.permanent ? "Permanently" : "NOT permanently");
     } else {
-        terminal_printf("Debug port is Unlocked %s.\r\n",
-                        debug_stat.permanent ? "Permanently" : "NOT permanently");
+        TERMINAL_LOG("Debug port is Unlocked %s.\r\n",
+                     debug_stat.permanent ? "Permanently" : "NOT permanently");
+    }
+    if (!debug_stat.permanent) {
+        ret = E_BAD_STATE;
     }
 
     return ret;
@@ -126,10 +130,9 @@ int swd_status(const char *parentName)
     debug_locked = debug_status(&debug_stat);
     (void)debug_locked;
 
-    terminal_printf("\n\rLocks left = %u, Unlocks left = %u, Debug port locked = %s\r\n",
-                    debug_stat.locks, debug_stat.unlocks, debug_stat.locked ? "YES" : "NO");
-    terminal_printf("Debug status is %s.\r\n",
-                    debug_stat.permanent ? "Permanent" : "NOT permanent");
+    TERMINAL_LOG("\n\rLocks left = %u, Unlocks left = %u, Debug port locked = %s\r\n",
+                 debug_stat.locks, debug_stat.unlocks, debug_stat.locked ? "YES" : "NO");
+    TERMINAL_LOG("Debug status is %s.\r\n", debug_stat.permanent ? "Permanent" : "NOT permanent");
 
     return ret;
 }
@@ -141,27 +144,30 @@ int crk_write(const char *parentName)
 {
     int ret = 0;
     int i;
-    extern unsigned char _p_key_start[]; // defined in linker script
-    extern unsigned char _p_key_end; // defined in linker script
-
-    unsigned int key_len = (&_p_key_end - _p_key_start);
+    uint32_t failedlines = 0;
+    unsigned int key_len;
+    uint8_t *key = mailbox_key(&key_len);
 
     // Is all byte 0xff ?
-    for (i = 0; i < key_len; i++) {
-        if (_p_key_start[i] != 0xFF) {
+    for (i = 0; key && (i < key_len); i++) {
+        if (key[i] != 0xFF) {
             break;
         }
     }
 
-    if (i == key_len) {
-        terminal_printf("\n\rCRK Invalid!\r\n");
+    if ((key == NULL) || (i == key_len)) {
+        TERMINAL_LOG("\n\rCRK Invalid!\r\n");
         return -1;
     }
 
-    terminal_hexdump("CRK:", (char *)_p_key_start, key_len);
-    ret = infoblock_write(INFOBLOCK_KEY_OFFSET, _p_key_start, key_len);
+    terminal_hexdump("CRK:", (char *)key, key_len);
+    ret = infoblock_write_verified(INFOBLOCK_KEY_OFFSET, key, key_len, &failedlines);
     if (ret == 0) {
-        terminal_printf("\n\rCRK Written!\r\n");
+        TERMINAL_LOG("\n\rCRK Written!\r\n");
+    } else if (failedlines) {
+        TERMINAL_LOG("\n\rCRK verify FAILED, line mask: 0x%08x\r\n", (unsigned int)failedlines);
+    } else {
+        TERMINAL_LOG("\n\rCRK write FAILED (%d)\r\n", ret);
     }
 
     return ret;
@@ -185,15 +191,92 @@ int crk_dump(const char *parentName)
     return ret;
 }
 
+/*
+ *  Check the table driven CRC15 against the bit-serial reference
+ */
+int crc15_check(const char *parentName)
+{
+    int ret;
+
+    ret = crc15_selftest();
+    TERMINAL_LOG("\n\rCRC15 self test: %s\r\n", (ret == E_NO_ERROR) ? "PASSED" : "FAILED");
+
+    return ret;
+}
+
+/*
+ *  Report how the asynchronous console output has been keeping up
+ */
+int terminal_stats(const char *parentName)
+{
+    terminal_tx_stats_t stats;
+
+    terminal_tx_stats(&stats);
+    if (stats.size == 0) {
+        TERMINAL_LOG("\n\rTX ring disabled, output is synchronous\r\n");
+    } else {
+        TERMINAL_LOG("\n\rTX ring: size %u, high water %u, overflows %u\r\n", stats.size,
+                     stats.highwater, stats.overflows);
+    }
+
+    return 0;
+}
+
+/*
+ *  Switch the dump commands between hex text and binary frames
+ */
+int terminal_toggle_binary(const char *parentName)
+{
+    terminal_set_binary(!terminal_get_binary());
+    TERMINAL_LOG("\n\rDump output: %s\r\n", terminal_get_binary() ? "binary frames" : "hex text");
+
+    return 0;
+}
+
+int terminal_toggle_compress(const char *parentName)
+{
+    terminal_set_compress(!terminal_get_compress());
+    TERMINAL_LOG("\n\rRepeated dump data: %s\r\n",
+                 terminal_get_compress() ? "collapsed" : "sent in full");
+
+    return 0;
+}
+
+/*
+ *  Agree on a faster console baud rate with the host, see negotiate_baud.py
+ */
+int negotiate_baud(const char *parentName)
+{
+    return terminal_negotiate_baud();
+}
+
+/*
+ *  Switch from the menus to the line oriented command mode, see command.h
+ */
+int command_mode(const char *parentName)
+{
+    return command_loop();
+}
+
+#ifdef BL1_PROBES
+/*
+ *  Print the cycle counter probes, see probe.h
+ */
+int timing_probes(const char *parentName)
+{
+    return probe_report();
+}
+#endif
+
 int secure_boot_toggle_mode(const char *parentName)
 {
     // Toggle boot mode
-    if (MXC_MCR->bypass0 == ME30_WARM_BOOT_MAGIC_VALUE) {
-        MXC_MCR->bypass0 = 0;
-        terminal_printf("\n\rWarm Boot Disabled.\r\n");
+    if (hal_mcr_bypass_read(0) == ME30_WARM_BOOT_MAGIC_VALUE) {
+        hal_mcr_bypass_write(0, 0);
+        TERMINAL_LOG("\n\rWarm Boot Disabled.\r\n");
     } else {
-        MXC_MCR->bypass0 = ME30_WARM_BOOT_MAGIC_VALUE;
-        terminal_printf("\n\rWarm Boot Enabled.\r\n");
+        hal_mcr_bypass_write(0, ME30_WARM_BOOT_MAGIC_VALUE);
+        TERMINAL_LOG("\n\rWarm Boot Enabled.\r\n");
     }
 
     return 0;
@@ -209,83 +292,99 @@ int secure_boot_is_enable(const char *parentName)
     int state = 0;
 
     state = infoblock_issecurebootenabled();
-    terminal_printf("\r\nSecure Boot: %s\r\n", (state == 1) ? "Enabled" : "NOT Enabled");
+    TERMINAL_LOG("\r\nSecure Boot: %s\r\n", (state == 1) ? "Enabled" : "NOT Enabled");
 
     return 0;
 }
 
 int secure_boot_enable(const char *parentName)
 {
-    int ret;
+    int ret = 0;
 
     if (infoblock_issecurebootenabled() == 0) {
+        // Never lock the debug port unless the key read back correctly, nor freeze it unlocked
+        mailbox_result_begin(MAILBOX_PHASE_CRK);
         ret = crk_write(NULL);
-        if (ret == 0) {
+        mailbox_result_end(MAILBOX_PHASE_CRK, ret);
+        if ((ret == 0) && (mailbox_lock_policy() >= MAILBOX_LOCK_DEBUG)) {
+            mailbox_result_begin(MAILBOX_PHASE_SWD_LOCK);
             ret = swd_lock(NULL);
-            if (ret == 0) {
-                ret = swd_set_config_permanently(NULL);
-            }
+            mailbox_result_end(MAILBOX_PHASE_SWD_LOCK, ret);
+        }
+        if ((ret == 0) && (mailbox_lock_policy() == MAILBOX_LOCK_PERMANENT)) {
+            mailbox_result_begin(MAILBOX_PHASE_SWD_PERMANENT);
+            ret = swd_set_config_permanently(NULL);
+            mailbox_result_end(MAILBOX_PHASE_SWD_PERMANENT, ret);
         }
 
-        if (ret == 0) {
-            terminal_printf("\n\rSecure boot enabled.\r\n");
+        if ((ret == 0) && (mailbox_lock_policy() == MAILBOX_LOCK_PERMANENT)) {
+            TERMINAL_LOG("\n\rSecure boot enabled.\r\n");
+        } else if (ret == 0) {
+            TERMINAL_LOG("\n\rSecure boot enabled, debug port %s.\r\n",
+                         (mailbox_lock_policy() == MAILBOX_LOCK_NONE) ? "left as is" :
+                                                                        "locked, not frozen");
         } else {
-            terminal_printf("\n\rSecure boot enable FAILED.\r\n");
+            TERMINAL_LOG("\n\rSecure boot enable FAILED.\r\n");
         }
     } else {
-        terminal_printf("\n\rSecure boot already enabled.\r\n");
+        TERMINAL_LOG("\n\rSecure boot already enabled.\r\n");
     }
 
-    return 0;
+    return ret;
 }
 
 int dump_device_infoblock(const char *parentName)
 {
-    int addr = MXC_INFO_MEM_BASE;
-    unsigned int i;
-    unsigned char buf[INFOBLOCK_LINE_SIZE * 2];
-    unsigned int last_size = 8 * 1024;
+    const uint8_t *buf;
+    int ret;
 
-    while (last_size) {
-        infoblock_unlock(MXC_INFO_MEM_BASE);
-        memcpy(buf, (uint8_t *)addr, sizeof(buf));
-        infoblock_lock(MXC_INFO_MEM_BASE);
-
-        for (i = 0; i < sizeof(buf); i++) {
-            if (!(i % 16)) {
-                terminal_printf("\n\r0x%08x:", (addr + i));
-            }
-            terminal_printf(" %02x", buf[i]);
-        }
-        last_size -= sizeof(buf);
-        addr += sizeof(buf);
+    if ((ret = infoblock_session_open()) != E_NO_ERROR) {
+        return ret;
     }
-    terminal_printf("\r\n");
 
-    return 0;
+    if ((buf = infoblock_session_view(0, INFOBLOCK_DEVICE_SECTION_SIZE)) == NULL) {
+        infoblock_session_close();
+        return E_BAD_STATE;
+    }
+    terminal_block_begin("device_infoblock", HAL_INFOBLOCK_ADDRESS, INFOBLOCK_DEVICE_SECTION_SIZE);
+    terminal_block_data(HAL_INFOBLOCK_ADDRESS, buf, INFOBLOCK_DEVICE_SECTION_SIZE, 0);
+    terminal_block_end();
+    if (!terminal_get_binary()) {
+        terminal_printf("\r\n");
+    }
+
+    return infoblock_session_close();
 }
 
 int dump_user_infoblock(const char *parentName)
 {
-    int addr = MXC_INFO_MEM_BASE + INFOBLOCK_USER_SECTION_OFFSET;
-    unsigned int i;
-    unsigned char buf[INFOBLOCK_LINE_SIZE * 2];
-    unsigned int last_size = 4 * 1024;
+    const uint8_t *buf;
+    int ret;
 
-    while (last_size) {
-        MXC_FLC_UnlockInfoBlock(MXC_INFO_MEM_BASE);
-        memcpy(buf, (uint8_t *)addr, sizeof(buf));
-        MXC_FLC_LockInfoBlock(MXC_INFO_MEM_BASE);
-        for (i = 0; i < sizeof(buf); i++) {
-            if (!(i % 16)) {
-                terminal_printf("\n\r0x%08x:", (addr + i));
-            }
-            // Convert 1 to 0, 0 to 1
-            terminal_printf(" %02x", buf[i] ^ 0xff);
-        }
-        last_size -= sizeof(buf);
-        addr += sizeof(buf);
+    if ((ret = infoblock_session_open()) != E_NO_ERROR) {
+        return ret;
     }
+
+    buf = infoblock_session_view(INFOBLOCK_USER_SECTION_OFFSET, INFOBLOCK_USER_SECTION_SIZE);
+    if (buf == NULL) {
+        infoblock_session_close();
+        return E_BAD_STATE;
+    }
+    // Convert 1 to 0, 0 to 1
+    terminal_block_begin("user_infoblock", HAL_INFOBLOCK_ADDRESS + INFOBLOCK_USER_SECTION_OFFSET,
+                         INFOBLOCK_USER_SECTION_SIZE);
+    terminal_block_data(HAL_INFOBLOCK_ADDRESS + INFOBLOCK_USER_SECTION_OFFSET, buf,
+                        INFOBLOCK_USER_SECTION_SIZE, TERMINAL_DUMP_INVERT);
+    terminal_block_end();
+
+    if ((ret = infoblock_session_close()) != E_NO_ERROR) {
+        return ret;
+    }
+
+    if (terminal_get_binary()) {
+        return 0;
+    }
+
     terminal_printf("\n\r");
     terminal_printf("Note:\n\r");
     terminal_printf("Each byte of this section XOR with 0xff while dumping\r\n");
@@ -298,24 +397,22 @@ int dump_user_infoblock(const char *parentName)
 
 int dump_flash(const char *parentName)
 {
-    int addr = MXC_FLASH_MEM_BASE + 0xf0000 + 16 * 1024;
-    unsigned int i;
-    unsigned char buf[INFOBLOCK_LINE_SIZE * 2];
+    int addr = HAL_FLASH_ADDRESS + 0xf0000 + 16 * 1024;
+    unsigned char buf[INFOBLOCK_LINE_SIZE * 16];
     unsigned int last_size = 1024;
 
+    terminal_block_begin("flash", addr, last_size);
     while (last_size) {
-        MXC_FLC_Read(addr, buf, sizeof(buf));
+        hal_flash_read(addr, buf, sizeof(buf));
 
-        for (i = 0; i < sizeof(buf); i++) {
-            if (!(i % 16)) {
-                terminal_printf("\n\r0x%08x:", (addr + i));
-            }
-            terminal_printf(" %02x", buf[i]);
-        }
+        terminal_block_data(addr, buf, sizeof(buf), 0);
         last_size -= sizeof(buf);
         addr += sizeof(buf);
     }
-    terminal_printf("\r\n");
+    terminal_block_end();
+    if (!terminal_get_binary()) {
+        terminal_printf("\r\n");
+    }
 
     return 0;
 }
@@ -324,14 +421,15 @@ int erase_user_infoblock(const char *parentName)
 {
     int ret;
 
-    ret = MXC_FLC_PageErase(MXC_INFO_MEM_BASE + INFOBLOCK_USER_SECTION_OFFSET);
+    ret = hal_infoblock_erase_user();
+    infoblock_shadow_invalidate(INFOBLOCK_USER_SECTION_OFFSET, INFOBLOCK_USER_SECTION_SIZE);
 
     return ret;
 }
 
 int mass_erase_flash(const char *parentName)
 {
-    MXC_FLC_MassErase();
+    hal_flash_mass_erase();
 
     return 0;
 }
@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2025 Analog Devices, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifdef BL1_PROBES
+
+/*******************************      INCLUDES    ****************************/
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "probe.h"
+#include "terminal.h"
+
+/******************************* Type Definitions ****************************/
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} probe_stats_t;
+
+/*******************************    Variables   ****************************/
+static const char *const probe_names[PROBE_COUNT] = {
+    "infoblock.read", "infoblock.write", "infoblock.crc", "flc.write",
+    "terminal.write", "terminal.flush", "step.usn",      "step.params",
+    "step.crk",       "step.swd_lock",  "step.swd_perm", "step.console",
+};
+
+static probe_stats_t probe_stats[PROBE_COUNT];
+
+/******************************* Static Functions ****************************/
+static uint32_t probe_us(uint64_t cycles)
+{
+    return (uint32_t)((cycles * 1000000u) / hal_cycles_hz());
+}
+
+/******************************* Public Functions ****************************/
+void probe_record(unsigned int id, uint32_t cycles)
+{
+    probe_stats_t *stats = &probe_stats[id];
+
+    if ((stats->count == 0) || (cycles < stats->min)) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    stats->count++;
+    stats->total += cycles;
+}
+
+void probe_reset(void)
+{
+    memset(probe_stats, 0, sizeof(probe_stats));
+}
+
+int probe_report(void)
+{
+    probe_stats_t snapshot[PROBE_COUNT];
+    unsigned int i;
+
+    // Printing the table runs the terminal probes, report them as they were before
+    memcpy(snapshot, probe_stats, sizeof(snapshot));
+
+    terminal_printf("\r\n%-16s %8s %10s %10s %10s %10s\r\n", "probe", "count", "min", "max",
+                    "mean", "total us");
+    for (i = 0; i < PROBE_COUNT; i++) {
+        if (snapshot[i].count == 0) {
+            continue;
+        }
+        terminal_printf("%-16s %8u %10u %10u %10u %10u\r\n", probe_names[i],
+                        (unsigned int)snapshot[i].count, (unsigned int)snapshot[i].min,
+                        (unsigned int)snapshot[i].max,
+                        (unsigned int)(snapshot[i].total / snapshot[i].count),
+                        (unsigned int)probe_us(snapshot[i].total));
+    }
+    terminal_printf("min, max and mean in cycles at %u Hz\r\n", (unsigned int)hal_cycles_hz());
+
+    return E_NO_ERROR;
+}
+
+#endif
@@ -20,12 +20,11 @@
 #include <stdio.h>
 #include <stdint.h>
 
-#include "mxc_device.h"
-#include "mcr_regs.h" // For BBREG0 register.
-
+#include "hal.h"
 #include "terminal.h"
 #include "menu_funcs.h"
 #include "infoblock.h"
+#include "mailbox.h"
 
 /***** Defines *****/
 
@@ -37,12 +36,28 @@ int provision_bootrom(void)
 {
     int ret;
 
-    terminal_printf("BBREG0 (@ 0x%08X) Status: 0x%08X\r\n", &(MXC_MCR->bypass0), MXC_MCR->bypass0);
-    terminal_printf("BBREG1 (@ 0x%08X) Status: 0x%08X\r\n", &(MXC_MCR->bypass1), MXC_MCR->bypass1);
-    if (MXC_MCR->bypass0 == ME30_WARM_BOOT_MAGIC_VALUE) {
-        terminal_printf("Warm Boot: Enabled\r\n");
+    switch (mailbox_params_status()) {
+    case E_NO_ERROR:
+        TERMINAL_LOG("Parameters: mailbox, lock policy %u, flags 0x%08x\r\n",
+                     mailbox_lock_policy(), mailbox_flags());
+        break;
+    case E_NONE_AVAIL:
+        TERMINAL_LOG("Parameters: .pubkey section\r\n");
+        break;
+    default:
+        // Never fall back to the ELF key when the host meant to pass another one
+        TERMINAL_LOG("Parameters: mailbox manifest INVALID, nothing provisioned\r\n");
+        return mailbox_params_status();
+    }
+
+    TERMINAL_LOG("BBREG0 (@ 0x%08X) Status: 0x%08X\r\n", hal_mcr_bypass_address(0),
+                 hal_mcr_bypass_read(0));
+    TERMINAL_LOG("BBREG1 (@ 0x%08X) Status: 0x%08X\r\n", hal_mcr_bypass_address(1),
+                 hal_mcr_bypass_read(1));
+    if (hal_mcr_bypass_read(0) == ME30_WARM_BOOT_MAGIC_VALUE) {
+        TERMINAL_LOG("Warm Boot: Enabled\r\n");
     } else {
-        terminal_printf("Warm Boot: Disabled\r\n");
+        TERMINAL_LOG("Warm Boot: Disabled\r\n");
     }
 
     ret = secure_boot_enable(NULL);
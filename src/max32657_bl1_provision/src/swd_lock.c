@@ -22,6 +22,7 @@
 
 #include "swd_lock.h"
 #include "infoblock.h"
+#include "terminal.h"
 
 #define E_NO_ERROR 0
 #define E_BAD_STATE -7
@@ -138,20 +139,32 @@ unsigned int debug_status(debug_status_t *ptr)
 {
     unsigned int locks, unlocks, locked, i, permanent;
     unsigned int currently_locked_locations, currently_unmodified_locations;
-    uint8_t data8[INFOBLOCK_WRITE_LOCK_LINE_SIZE];
-    uint16_t *data16 = (uint16_t *)&data8[0];
+    const uint8_t *data8;
+    const uint16_t *data16;
     uint32_t lockoffset;
 
     locked = locks = unlocks = permanent = 0;
     currently_locked_locations = currently_unmodified_locations = 0;
-    // align infoblock read to the line lock size since this may change from part to part
+
+    // align infoblock view to the line lock size since this may change from part to part
     lockoffset = INFOBLOCK_ICE_LOCK_OFFSET & ~(INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1);
-    infoblock_read(lockoffset, data8, INFOBLOCK_WRITE_LOCK_LINE_SIZE);
+    infoblock_session_open();
+    data8 = infoblock_session_view(lockoffset, INFOBLOCK_WRITE_LOCK_LINE_SIZE);
+    if (data8 == NULL) {
+        // Unable to access the lock line, report nothing available
+        infoblock_session_close();
+        if (ptr) {
+            ptr->locks = ptr->unlocks = ptr->locked = ptr->permanent = 0;
+        }
+        return 0;
+    }
+    data16 = (const uint16_t *)data8;
 
 #ifdef SWD_LOCK_DEBUG
-    printf("[debug_lock_words] Lock0=0x%04x Lock1=0x%04x Lock2=0x%04x Lock3=0x%04x Permanent=>%s\n",
-           data16[0], data16[1], data16[2], data16[3],
-           ((data8[INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1] & (1 << 7)) == 0) ? "0=Yes" : "1=No");
+    TERMINAL_LOG(
+        "[debug_lock_words] Lock0=0x%04x Lock1=0x%04x Lock2=0x%04x Lock3=0x%04x Permanent=>%s\r\n",
+        data16[0], data16[1], data16[2], data16[3],
+        ((data8[INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1] & (1 << 7)) == 0) ? "0=Yes" : "1=No");
 #endif /* SWD_LOCK_DEBUG */
 
     for (i = 0; i < (INFOBLOCK_ICE_LOCK_SIZE / sizeof(uint16_t)); ++i) {
@@ -201,6 +214,8 @@ unsigned int debug_status(debug_status_t *ptr)
         permanent = 1;
     }
 
+    infoblock_session_close();
+
     if (ptr) {
         ptr->locks = locks;
         ptr->unlocks = unlocks;
@@ -228,7 +243,7 @@ int debug_set_config_permanently(void)
     // top bit if cleared = permanent
     if ((data8[INFOBLOCK_WRITE_LOCK_LINE_SIZE - 1] & (1 << 7)) == 0) {
 #ifdef SWD_LOCK_DEBUG
-        printf("Already permanently locked.\n");
+        TERMINAL_LOG("Already permanently locked.\r\n");
 #endif /* SWD_LOCK_DEBUG */
         result = E_NO_ERROR;
     } else {
@@ -21,24 +21,236 @@
 #include <stdio.h>
 #include <stdarg.h>
 
-#include "uart.h"
+#include "hal.h"
 #include "terminal.h"
+#include "probe.h"
 
 /*******************************      DEFINES     ****************************/
-#define PC_COM_PORT MXC_UART
+#ifdef TERMINAL_ASYNC_TX
+#ifndef TERMINAL_TX_RING_SIZE
+#define TERMINAL_TX_RING_SIZE 1024
+#endif
+#if (TERMINAL_TX_RING_SIZE & (TERMINAL_TX_RING_SIZE - 1)) != 0
+#error "TERMINAL_TX_RING_SIZE must be a power of two"
+#endif
+#endif
+
+// Largest accepted difference between a requested and a real baud rate, in parts per thousand
+#define TERMINAL_BAUD_MAX_ERROR 20
+// How long each side waits for the other while switching rates
+#define TERMINAL_BAUD_TIMEOUT_MS 1000
+// Line silence that ends a failed handshake
+#define TERMINAL_BAUD_QUIET_MS 50
+// How long the host has for each character of its reply to the offer
+#define TERMINAL_BAUD_REPLY_MS 5000
+// Longest reply accepted, the highest rate has 7 digits
+#define TERMINAL_BAUD_REPLY_MAX 12
+
+// Bytes per row of a block dump in text mode
+#define TERMINAL_BLOCK_WIDTH 16
+// Shortest run of one byte value sent as a fill frame, shorter runs cost more than they save
+#define TERMINAL_BLOCK_FILL_MIN 16
 
 /******************************* Type Definitions ****************************/
 
 /*******************************    Variables   ****************************/
+#ifdef TERMINAL_ASYNC_TX
+/*
+ * Single producer (terminal_printf and friends) single consumer (UART TX interrupt) ring.
+ * Head and tail run freely and are only masked on access, head is written by the producer
+ * only and tail by the interrupt only, so no lock is needed.
+ */
+static uint8_t terminal_tx_ring[TERMINAL_TX_RING_SIZE];
+static volatile uint32_t terminal_tx_head;
+static volatile uint32_t terminal_tx_tail;
+static unsigned int terminal_tx_async;
+static terminal_tx_stats_t terminal_tx_stats_data;
+#endif
+
+static const char terminal_hex_upper[16] = "0123456789ABCDEF";
+static const char terminal_hex_lower[16] = "0123456789abcdef";
+
+// Rates offered by terminal_negotiate_baud(), only those the UART clock can hit are offered
+static const unsigned int terminal_baud_table[] = {
+    115200, 230400, 460800, 921600, 1000000, 1500000, 2000000, 3000000, 4000000,
+};
+// Both edges, all ones, all zeros and nibble patterns to catch a sampling error
+static const uint8_t terminal_baud_pattern[8] = { 0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0, 0x33, 0xCC };
+
+// Binary framing state, see terminal_frame_send()
+static unsigned int terminal_binary_mode;
+static uint8_t terminal_frame_seq;
+static uint32_t terminal_block_crc;
+
+/*
+ * Compressed block dump state. A run is either rows repeating the last printed row (text
+ * mode) or bytes all equal to run_value (binary mode). It is held back until something
+ * different shows up, so runs carry across terminal_block_data() calls.
+ */
+static unsigned int terminal_compress_mode;
+static uint8_t terminal_block_row[TERMINAL_BLOCK_WIDTH];
+static unsigned int terminal_block_row_valid;
+static uint32_t terminal_block_run_address;
+static uint32_t terminal_block_run_length;
+static uint8_t terminal_block_run_value;
+
+// CRC32 (reflected 0xEDB88320, same as zlib) of every nibble value
+static const uint32_t terminal_crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
 
 /******************************* Static Functions ****************************/
+#ifdef TERMINAL_ASYNC_TX
+/*
+ * Runs from the UART TX interrupt, and from terminal_tx_kick() with it masked,
+ * moves ring contents into the TX FIFO
+ */
+static void terminal_tx_isr(void)
+{
+    uint32_t tail = terminal_tx_tail;
+    uint32_t head = __atomic_load_n(&terminal_tx_head, __ATOMIC_ACQUIRE);
+    uint32_t index, chunk;
+    int written;
+
+    while (tail != head) {
+        index = tail & (TERMINAL_TX_RING_SIZE - 1);
+        chunk = head - tail;
+        if (chunk > TERMINAL_TX_RING_SIZE - index) {
+            chunk = TERMINAL_TX_RING_SIZE - index;
+        }
+
+        if ((written = hal_uart_tx_fifo_write(&terminal_tx_ring[index], chunk)) <= 0) {
+            // FIFO full, the interrupt fires again once it drains
+            break;
+        }
+        tail += written;
+    }
+
+    __atomic_store_n(&terminal_tx_tail, tail, __ATOMIC_RELEASE);
+
+    if (tail == head) {
+        hal_uart_tx_irq_enable(0);
+    }
+}
+
+/*
+ * Start draining the ring. TX_HE only latches when the FIFO level falls to half, so enabling
+ * the interrupt over an idle FIFO never raises it: fill the FIFO from here first, with the
+ * interrupt masked, and enable it only if the ring still holds data for it to move.
+ */
+static void terminal_tx_kick(void)
+{
+    hal_uart_tx_irq_enable(0);
+    terminal_tx_isr();
+
+    if (terminal_tx_tail != __atomic_load_n(&terminal_tx_head, __ATOMIC_ACQUIRE)) {
+        hal_uart_tx_irq_enable(1);
+    }
+}
+#endif
+
+/*
+ * Also used by mailbox.c, declared in terminal.h
+ */
+uint32_t terminal_crc32(uint32_t crc, const uint8_t *data, unsigned int len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ terminal_crc32_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ terminal_crc32_nibble[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+/*
+ * Consistent Overhead Byte Stuffing, out must hold len + len / 254 + 1 bytes.
+ * Returns the encoded length, the output never contains a zero byte.
+ */
+static unsigned int terminal_cobs_encode(const uint8_t *in, unsigned int len, uint8_t *out)
+{
+    unsigned int code_pos = 0;
+    unsigned int pos = 1;
+    uint8_t code = 1;
+
+    while (len--) {
+        if (*in) {
+            out[pos++] = *in;
+            code++;
+        }
+        if ((*in++ == 0) || (code == 0xFF)) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+
+    return pos;
+}
+
+static void terminal_write(const uint8_t *data, int len)
+{
+    int wLen;
+#ifdef TERMINAL_ASYNC_TX
+    uint32_t head, tail, index, space, chunk;
+    int waited = 0;
+
+    if (terminal_tx_async) {
+        while (len > 0) {
+            head = terminal_tx_head;
+            tail = __atomic_load_n(&terminal_tx_tail, __ATOMIC_ACQUIRE);
+            space = TERMINAL_TX_RING_SIZE - (head - tail);
+            if (space == 0) {
+                // Ring full, wait for the interrupt to make room
+                if (!waited) {
+                    terminal_tx_stats_data.overflows++;
+                    waited = 1;
+                }
+                terminal_tx_kick();
+                continue;
+            }
+
+            index = head & (TERMINAL_TX_RING_SIZE - 1);
+            chunk = (space > TERMINAL_TX_RING_SIZE - index) ? (TERMINAL_TX_RING_SIZE - index) : space;
+            chunk = (chunk > (uint32_t)len) ? (uint32_t)len : chunk;
+            memcpy(&terminal_tx_ring[index], data, chunk);
+            __atomic_store_n(&terminal_tx_head, head + chunk, __ATOMIC_RELEASE);
+
+            if ((head + chunk - tail) > terminal_tx_stats_data.highwater) {
+                terminal_tx_stats_data.highwater = head + chunk - tail;
+            }
+            data += chunk;
+            len -= chunk;
+        }
+
+        terminal_tx_kick();
+        return;
+    }
+#endif
+
+    while (len > 0) {
+        wLen = len;
+        hal_uart_write(data, &wLen);
+        data += wLen;
+        len -= wLen;
+    }
+}
 
 /******************************* Public Functions ****************************/
 int terminal_init(void)
 {
     int ret = 0;
 
-    //ret = MXC_UART_Init(PC_COM_PORT, 115200, MXC_UART_IBRO_CLK);
+    //ret = hal_uart_init(115200);
+
+#ifdef TERMINAL_ASYNC_TX
+    // Fall back to blocking writes if the TX interrupt is not available
+    terminal_tx_async = (hal_uart_tx_async_init(terminal_tx_isr) == E_NO_ERROR);
+    terminal_tx_stats_data.size = TERMINAL_TX_RING_SIZE;
+#endif
 
     return ret;
 }
@@ -50,12 +262,13 @@ int terminal_read_num(unsigned int timeout)
     int num = 0;
 
     while (1) {
-        key = MXC_UART_ReadCharacter(PC_COM_PORT);
+        key = hal_uart_read_char();
 
         if (key > 0) {
             if (key >= 0x20) {
-                //echo non control char
-                MXC_UART_WriteCharacter(PC_COM_PORT, (unsigned char)key);
+                //echo non control char, through the ring to keep it in order with pending output
+                uint8_t echo = (uint8_t)key;
+                terminal_write(&echo, 1);
             }
 
             if ((key >= '0') && (key <= '9')) {
@@ -71,11 +284,41 @@ int terminal_read_num(unsigned int timeout)
         }
     }
 
-    MXC_UART_ClearRXFIFO(PC_COM_PORT);
+    hal_uart_clear_rx();
 
     return num;
 }
 
+int terminal_read_line(char *line, int size)
+{
+    int key;
+    int len = 0;
+
+    while (1) {
+        key = hal_uart_read_char();
+        if (key < 0) {
+            continue;
+        }
+
+        if ((key == '\n') || (key == '\r')) {
+            // Ignore the second half of a CR LF pair
+            if (len == 0) {
+                continue;
+            }
+            break;
+        } else if ((key == 0x08) || (key == 0x7F)) {
+            if (len > 0) {
+                len--;
+            }
+        } else if ((key >= 0x20) && (len < size - 1)) {
+            line[len++] = (char)key;
+        }
+    }
+    line[len] = '\0';
+
+    return len;
+}
+
 int terminal_select_from_list(const char *title, const list_t *items, int nb_items, int nb_col)
 {
     int i, k;
@@ -154,40 +397,529 @@ int terminal_printf(const char *format, ...)
 {
     char buffer[512];
     int len;
-    int wLen = 0;
-    int count = 0;
 
     __gnuc_va_list args;
     va_start(args, format);
     len = vsnprintf(buffer, sizeof(buffer), format, args);
     if (len > 0) {
-        while (len) {
-            wLen = len;
-            MXC_UART_Write(PC_COM_PORT, (uint8_t *)&buffer[count], &wLen);
-            count += wLen;
-            len -= wLen;
+        if (len >= (int)sizeof(buffer)) {
+            len = sizeof(buffer) - 1;
         }
+        PROBE_BEGIN(PROBE_TERMINAL_WRITE);
+        terminal_write((uint8_t *)buffer, len);
+        PROBE_END(PROBE_TERMINAL_WRITE);
     }
     va_end(args);
 
-    return len;
+    return 0;
 }
 
-void terminal_hexdump(const char *title, char *buf, unsigned int len)
+int terminal_flush(void)
+{
+#ifdef TERMINAL_ASYNC_TX
+    PROBE_BEGIN(PROBE_TERMINAL_FLUSH);
+
+    if (terminal_tx_async) {
+        while (terminal_tx_tail != terminal_tx_head) {
+            terminal_tx_kick();
+        }
+    }
+
+    PROBE_END(PROBE_TERMINAL_FLUSH);
+#endif
+
+    return 0;
+}
+
+void terminal_tx_stats(terminal_tx_stats_t *stats)
 {
+#ifdef TERMINAL_ASYNC_TX
+    *stats = terminal_tx_stats_data;
+#else
+    stats->size = stats->highwater = stats->overflows = 0;
+#endif
+}
+
+void terminal_dump(uint32_t address, const uint8_t *data, unsigned int len, unsigned int width,
+                   unsigned int flags)
+{
+    // Worst case row: address prefix, three characters per byte and the ASCII gutter
+    char row[13 + TERMINAL_DUMP_MAX_WIDTH * 3 + 3 + TERMINAL_DUMP_MAX_WIDTH];
+    const char *hex = (flags & TERMINAL_DUMP_ADDRESS) ? terminal_hex_lower : terminal_hex_upper;
+    uint8_t mask = (flags & TERMINAL_DUMP_INVERT) ? 0xFF : 0x00;
+    unsigned int i, count, pos;
+    uint8_t byte;
+    int shift;
+
+    if ((width == 0) || (width > TERMINAL_DUMP_MAX_WIDTH)) {
+        width = 16;
+    }
+
+    while (len) {
+        count = (len > width) ? width : len;
+        pos = 0;
+
+        if (flags & TERMINAL_DUMP_ADDRESS) {
+            // "\n\r0x%08x:" then " %02x" per byte
+            row[pos++] = '\n';
+            row[pos++] = '\r';
+            row[pos++] = '0';
+            row[pos++] = 'x';
+            for (shift = 28; shift >= 0; shift -= 4) {
+                row[pos++] = hex[(address >> shift) & 0x0F];
+            }
+            row[pos++] = ':';
+            for (i = 0; i < count; i++) {
+                byte = data[i] ^ mask;
+                row[pos++] = ' ';
+                row[pos++] = hex[byte >> 4];
+                row[pos++] = hex[byte & 0x0F];
+            }
+        } else {
+            // "\r\n" then "%02X " per byte
+            row[pos++] = '\r';
+            row[pos++] = '\n';
+            for (i = 0; i < count; i++) {
+                byte = data[i] ^ mask;
+                row[pos++] = hex[byte >> 4];
+                row[pos++] = hex[byte & 0x0F];
+                row[pos++] = ' ';
+            }
+        }
+
+        if (flags & TERMINAL_DUMP_ASCII) {
+            // Pad a short last row so the gutter stays aligned
+            for (i = count; i < width; i++) {
+                row[pos++] = ' ';
+                row[pos++] = ' ';
+                row[pos++] = ' ';
+            }
+            row[pos++] = ' ';
+            row[pos++] = '|';
+            for (i = 0; i < count; i++) {
+                byte = data[i] ^ mask;
+                row[pos++] = ((byte >= 0x20) && (byte < 0x7F)) ? (char)byte : '.';
+            }
+            row[pos++] = '|';
+        }
+
+        terminal_write((uint8_t *)row, pos);
+
+        address += count;
+        data += count;
+        len -= count;
+    }
+}
+
+static int terminal_baud_usable(unsigned int baud, unsigned int actual)
+{
+    unsigned int error = (actual > baud) ? (actual - baud) : (baud - actual);
+
+    return (actual != 0) && ((uint64_t)error * 1000 <= (uint64_t)baud * TERMINAL_BAUD_MAX_ERROR);
+}
+
+/*
+ * Read the rate picked by the host, digits ended by CR or LF. Unlike terminal_read_num()
+ * every character is waited for a bounded time, a silent host must not hang the firmware.
+ */
+static int terminal_read_baud_reply(void)
+{
+    int baud = 0;
+    int c;
     unsigned int i;
 
-    if (title) {
-        terminal_printf("%s", title);
+    for (i = 0; i < TERMINAL_BAUD_REPLY_MAX; i++) {
+        if ((c = hal_uart_read_char_timeout(TERMINAL_BAUD_REPLY_MS)) < 0) {
+            return E_TIME_OUT;
+        }
+        if ((c == '\r') || (c == '\n')) {
+            return baud;
+        }
+        if ((c < '0') || (c > '9')) {
+            // Escape, or anything else, declines the offer
+            return E_BAD_PARAM;
+        }
+        baud = baud * 10 + (c - '0');
+    }
+
+    return E_BAD_PARAM;
+}
+
+int terminal_negotiate_baud(void)
+{
+    int previous = hal_uart_get_baud();
+    int baud, actual, c;
+    unsigned int i, offered;
+
+    // Offer every rate the divisor can produce accurately
+    terminal_printf("\r\nBAUD-OFFER");
+    for (i = 0; i < sizeof(terminal_baud_table) / sizeof(terminal_baud_table[0]); i++) {
+        if (terminal_baud_usable(terminal_baud_table[i],
+                                 hal_uart_baud_actual(terminal_baud_table[i]))) {
+            terminal_printf(" %u", terminal_baud_table[i]);
+        }
+    }
+    terminal_printf("\r\n");
+
+    // Nothing has changed yet, on a timeout or a bad reply the old rate simply stays
+    if ((baud = terminal_read_baud_reply()) < 0) {
+        hal_uart_clear_rx();
+        terminal_printf("\r\nBAUD-FAIL\r\n");
+        return baud;
+    }
+    offered = 0;
+    for (i = 0; i < sizeof(terminal_baud_table) / sizeof(terminal_baud_table[0]); i++) {
+        if ((baud == (int)terminal_baud_table[i]) &&
+            terminal_baud_usable(baud, hal_uart_baud_actual(baud))) {
+            offered = 1;
+        }
+    }
+    if (!offered) {
+        terminal_printf("\r\nBAUD-FAIL\r\n");
+        return E_BAD_PARAM;
+    }
+
+    // Last message at the old rate, it must be fully out before switching
+    terminal_printf("\r\nBAUD-OK %d\r\n", baud);
+    terminal_flush();
+    hal_uart_tx_wait_idle();
+
+    actual = hal_uart_set_baud(baud);
+    if (terminal_baud_usable(baud, actual)) {
+        // The host sends the pattern at the new rate, it is echoed once it all arrived intact
+        hal_uart_clear_rx();
+        for (i = 0; i < sizeof(terminal_baud_pattern); i++) {
+            c = hal_uart_read_char_timeout(TERMINAL_BAUD_TIMEOUT_MS);
+            if (c != terminal_baud_pattern[i]) {
+                break;
+            }
+        }
+
+        if (i == sizeof(terminal_baud_pattern)) {
+            terminal_write(terminal_baud_pattern, sizeof(terminal_baud_pattern));
+            terminal_flush();
+
+            // The host confirms it got the echo, otherwise it went back to the old rate
+            if (hal_uart_read_char_timeout(TERMINAL_BAUD_TIMEOUT_MS) == '\r') {
+                return E_NO_ERROR;
+            }
+        }
     }
 
-    /* Print buffer bytes */
+    // Swallow the rest of the pattern so it is not taken as menu input
+    while (hal_uart_read_char_timeout(TERMINAL_BAUD_QUIET_MS) >= 0) {}
+
+    terminal_flush();
+    hal_uart_tx_wait_idle();
+    if (previous > 0) {
+        hal_uart_set_baud(previous);
+    }
+    hal_uart_clear_rx();
+    terminal_printf("\r\nBAUD-FAIL\r\n");
+
+    return E_COMM_ERR;
+}
+
+void terminal_set_binary(int enable)
+{
+    terminal_binary_mode = (enable != 0);
+}
+
+int terminal_get_binary(void)
+{
+    return terminal_binary_mode;
+}
+
+void terminal_set_compress(int enable)
+{
+    terminal_compress_mode = (enable != 0);
+}
+
+int terminal_get_compress(void)
+{
+    return terminal_compress_mode;
+}
+
+int terminal_frame_send(uint8_t type, const uint8_t *header, unsigned int headerlen,
+                        const uint8_t *data, unsigned int len, uint8_t mask)
+{
+    uint8_t frame[2 + TERMINAL_FRAME_MAX_PAYLOAD + 4];
+    // Leading delimiter, COBS overhead and trailing delimiter
+    uint8_t encoded[1 + sizeof(frame) + sizeof(frame) / 254 + 1 + 1];
+    unsigned int pos = 0;
+    unsigned int i;
+    uint32_t crc;
+
+    if ((headerlen + len) > TERMINAL_FRAME_MAX_PAYLOAD) {
+        return E_BAD_PARAM;
+    }
+
+    frame[pos++] = type;
+    frame[pos++] = terminal_frame_seq++;
+    memcpy(&frame[pos], header, headerlen);
+    pos += headerlen;
     for (i = 0; i < len; i++) {
-        if (!(i % 16)) {
-            terminal_printf("\r\n");
+        frame[pos++] = data[i] ^ mask;
+    }
+
+    crc = terminal_crc32(0, frame, pos);
+    frame[pos++] = (uint8_t)crc;
+    frame[pos++] = (uint8_t)(crc >> 8);
+    frame[pos++] = (uint8_t)(crc >> 16);
+    frame[pos++] = (uint8_t)(crc >> 24);
+
+    // Delimit on both sides so the host resynchronizes after any text output
+    encoded[0] = 0;
+    i = 1 + terminal_cobs_encode(frame, pos, &encoded[1]);
+    encoded[i++] = 0;
+
+    terminal_write(encoded, i);
+
+    return E_NO_ERROR;
+}
+
+static void terminal_put_le32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+static void terminal_block_send_data(uint32_t address, const uint8_t *data, unsigned int len,
+                                     uint8_t mask)
+{
+    uint8_t header[4];
+    unsigned int chunk, i;
+    uint8_t byte;
+
+    while (len) {
+        chunk = (len > (TERMINAL_FRAME_MAX_PAYLOAD - sizeof(header))) ?
+                    (TERMINAL_FRAME_MAX_PAYLOAD - sizeof(header)) :
+                    len;
+
+        // End to end CRC of the block as the host will store it
+        for (i = 0; i < chunk; i++) {
+            byte = data[i] ^ mask;
+            terminal_block_crc = terminal_crc32(terminal_block_crc, &byte, 1);
+        }
+
+        terminal_put_le32(header, address);
+        terminal_frame_send(TERMINAL_FRAME_DATA, header, sizeof(header), data, chunk, mask);
+
+        address += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/*
+ * Send the pending run, as a fill frame in binary mode and as a range marker otherwise
+ */
+static void terminal_block_flush_run(void)
+{
+    uint8_t header[9];
+    uint32_t i;
+
+    if (terminal_block_run_length == 0) {
+        return;
+    }
+
+    if (terminal_binary_mode) {
+        for (i = 0; i < terminal_block_run_length; i++) {
+            terminal_block_crc = terminal_crc32(terminal_block_crc, &terminal_block_run_value, 1);
         }
-        terminal_printf("%02X ", buf[i]);
+        terminal_put_le32(&header[0], terminal_block_run_address);
+        terminal_put_le32(&header[4], terminal_block_run_length);
+        header[8] = terminal_block_run_value;
+        terminal_frame_send(TERMINAL_FRAME_FILL, header, sizeof(header), NULL, 0, 0);
+    } else {
+        terminal_printf("\n\r0x%08x-0x%08x: *", (unsigned int)terminal_block_run_address,
+                        (unsigned int)(terminal_block_run_address + terminal_block_run_length - 1));
     }
 
+    terminal_block_run_length = 0;
+}
+
+static void terminal_block_text_compressed(uint32_t address, const uint8_t *data,
+                                           unsigned int len, unsigned int flags)
+{
+    uint8_t mask = (flags & TERMINAL_DUMP_INVERT) ? 0xFF : 0x00;
+    unsigned int count, i;
+
+    while (len) {
+        count = (len > TERMINAL_BLOCK_WIDTH) ? TERMINAL_BLOCK_WIDTH : len;
+
+        for (i = 0; terminal_block_row_valid && (i < count); i++) {
+            if ((data[i] ^ mask) != terminal_block_row[i]) {
+                break;
+            }
+        }
+
+        if ((count == TERMINAL_BLOCK_WIDTH) && terminal_block_row_valid && (i == count)) {
+            if (terminal_block_run_length == 0) {
+                terminal_block_run_address = address;
+            }
+            terminal_block_run_length += count;
+        } else {
+            terminal_block_flush_run();
+            terminal_dump(address, data, count, TERMINAL_BLOCK_WIDTH,
+                          flags | TERMINAL_DUMP_ADDRESS);
+            for (i = 0; i < count; i++) {
+                terminal_block_row[i] = data[i] ^ mask;
+            }
+            // Only whole rows can be repeated
+            terminal_block_row_valid = (count == TERMINAL_BLOCK_WIDTH);
+        }
+
+        address += count;
+        data += count;
+        len -= count;
+    }
+}
+
+// Number of bytes from the start of data equal to the first one
+static unsigned int terminal_block_run(const uint8_t *data, unsigned int len)
+{
+    unsigned int run = 1;
+
+    while ((run < len) && (data[run] == data[0])) {
+        run++;
+    }
+
+    return run;
+}
+
+static void terminal_block_binary_compressed(uint32_t address, const uint8_t *data,
+                                             unsigned int len, uint8_t mask)
+{
+    unsigned int run, literal;
+
+    while (len) {
+        run = terminal_block_run(data, len);
+
+        if ((terminal_block_run_length != 0) &&
+            (address == terminal_block_run_address + terminal_block_run_length) &&
+            ((data[0] ^ mask) == terminal_block_run_value)) {
+            // Continues the pending run, possibly from an earlier call
+            terminal_block_run_length += run;
+        } else if (run >= TERMINAL_BLOCK_FILL_MIN) {
+            terminal_block_flush_run();
+            terminal_block_run_address = address;
+            terminal_block_run_length = run;
+            terminal_block_run_value = data[0] ^ mask;
+        } else {
+            // Everything up to the next run worth a fill frame goes out as data
+            terminal_block_flush_run();
+            for (literal = run; literal < len; literal += run) {
+                run = terminal_block_run(&data[literal], len - literal);
+                if (run >= TERMINAL_BLOCK_FILL_MIN) {
+                    break;
+                }
+            }
+            terminal_block_send_data(address, data, literal, mask);
+            run = literal;
+        }
+
+        address += run;
+        data += run;
+        len -= run;
+    }
+}
+
+void terminal_block_begin(const char *name, uint32_t address, uint32_t length)
+{
+    uint8_t header[8];
+
+    terminal_block_row_valid = 0;
+    terminal_block_run_length = 0;
+
+    if (!terminal_binary_mode) {
+        return;
+    }
+
+    terminal_block_crc = 0;
+    terminal_put_le32(&header[0], address);
+    terminal_put_le32(&header[4], length);
+    terminal_frame_send(TERMINAL_FRAME_BEGIN, header, sizeof(header), (const uint8_t *)name,
+                        strlen(name), 0);
+}
+
+void terminal_block_data(uint32_t address, const uint8_t *data, unsigned int len,
+                         unsigned int flags)
+{
+    uint8_t mask = (flags & TERMINAL_DUMP_INVERT) ? 0xFF : 0x00;
+
+    if (!terminal_binary_mode) {
+        if (terminal_compress_mode) {
+            terminal_block_text_compressed(address, data, len, flags);
+        } else {
+            terminal_dump(address, data, len, TERMINAL_BLOCK_WIDTH, flags | TERMINAL_DUMP_ADDRESS);
+        }
+    } else if (terminal_compress_mode) {
+        terminal_block_binary_compressed(address, data, len, mask);
+    } else {
+        terminal_block_send_data(address, data, len, mask);
+    }
+}
+
+void terminal_block_end(void)
+{
+    uint8_t trailer[4];
+
+    terminal_block_flush_run();
+
+    if (!terminal_binary_mode) {
+        return;
+    }
+
+    terminal_put_le32(trailer, terminal_block_crc);
+    terminal_frame_send(TERMINAL_FRAME_END, trailer, sizeof(trailer), NULL, 0, 0);
+}
+
+int terminal_log_send(const char *format, const terminal_log_arg_t *args, unsigned int count)
+{
+    uint8_t header[4];
+    uint8_t payload[TERMINAL_FRAME_MAX_PAYLOAD - sizeof(header)];
+    unsigned int pos = 0;
+    unsigned int i;
+    size_t len;
+
+    // The format only exists in the ELF, its address there is all the host needs
+    terminal_put_le32(header, (uint32_t)(uintptr_t)format);
+
+    for (i = 0; i < count; i++) {
+        if (args[i].string) {
+            // Truncated to fit, the host still finds the NUL
+            len = strlen(args[i].string);
+            if (len > sizeof(payload) - pos - 1) {
+                len = sizeof(payload) - pos - 1;
+            }
+            memcpy(&payload[pos], args[i].string, len);
+            pos += len;
+            payload[pos++] = '\0';
+        } else {
+            if (pos + 4 > sizeof(payload)) {
+                return E_BAD_PARAM;
+            }
+            terminal_put_le32(&payload[pos], args[i].value);
+            pos += 4;
+        }
+        if (pos == sizeof(payload)) {
+            break;
+        }
+    }
+
+    return terminal_frame_send(TERMINAL_FRAME_LOG, header, sizeof(header), payload, pos, 0);
+}
+
+void terminal_hexdump(const char *title, char *buf, unsigned int len)
+{
+    if (title) {
+        terminal_printf("%s", title);
+    }
+
+    terminal_dump(0, (const uint8_t *)buf, len, 16, 0);
+
     terminal_printf("\r\n");
 }
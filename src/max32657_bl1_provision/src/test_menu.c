@@ -20,9 +20,7 @@
 #include <stdio.h>
 #include <stdint.h>
 
-#include "mxc_device.h"
-#include "mcr_regs.h" // For BBREG0 register.
-
+#include "hal.h"
 #include "terminal.h"
 #include "menu_funcs.h"
 #include "infoblock.h"
@@ -40,6 +38,15 @@ static list_t list[] = {
     { "Dump User Info Block", dump_user_infoblock },
     { "Erase User Info Block", erase_user_infoblock },
     { "Mass Erase FLC", mass_erase_flash },
+    { "CRC15 Self Test", crc15_check },
+    { "Terminal TX Statistics", terminal_stats },
+    { "Toggle Binary Dump Mode", terminal_toggle_binary },
+    { "Toggle Compressed Dumps", terminal_toggle_compress },
+    { "Negotiate Baud Rate", negotiate_baud },
+    { "Command Mode", command_mode },
+#ifdef BL1_PROBES
+    { "Timing Probes", timing_probes },
+#endif
 };
 
 // *****************************************************************************